@@ -1,15 +1,33 @@
 #ifndef RDMA_LIBRARY_HUGEPAGE_HH
 #define RDMA_LIBRARY_HUGEPAGE_HH
 
+#include <dirent.h>
+#include <linux/mempolicy.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <fstream>
+#include <thread>
 
 #include "types.hh"
 #include "utils.hh"
 
+// pages are selected at runtime: 1GB huge pages (for buffers of at least
+// 1GB) -> 2MB huge pages -> transparent huge pages -> normal pages, a pool of
+// huge pages is only used if it has enough free pages on the NUMA node of the
+// NIC (otherwise faulting a page raises SIGBUS), the buffer is bound to this
+// node (if it is known) independently of the process' memory policy
 template <typename T>
 class HugePage {
+  enum class PageType { gigantic, huge, transparent, normal };
+
+  static constexpr size_t GIGANTIC_PAGE_SIZE = 1ul << 30;
+  static constexpr size_t HUGE_PAGE_SIZE = 2ul << 20;
+  static constexpr u32 PREFAULT_THREADS = 8;
+  static constexpr size_t PREFAULT_CHUNK = 256ul << 20;  // min bytes per thread
+
 public:
   void allocate(size_t size) {
     lib_assert(buffer_size == 0, "Buffer has been already allocated");
@@ -17,27 +35,22 @@ public:
     buffer_length = size / sizeof(T);
     size_left_ = size;
 
+    print_status("map huge page");
 #ifdef NOHUGEPAGES
-    buffer_ = static_cast<T*>(std::aligned_alloc(64, buffer_size));
-    lib_assert(reinterpret_cast<u64>(buffer_) % 64 == 0,
-               "Not cache-line aligned");
-    std::cerr << "allocated ALIGNED MEM (no hugepage) at "
-              << reinterpret_cast<u64>(buffer_) << " with buffer size "
-              << buffer_size << std::endl;
+    map_pages(false);
 #else
-    print_status("map huge page");
-    void* ptr = mmap(NULL,
-                     buffer_size,
-                     PROT_READ | PROT_WRITE,
-                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
-                     -1,
-                     0);
-    lib_assert(ptr != MAP_FAILED, "Allocating huge-pages failed");
-    lib_assert(reinterpret_cast<u64>(ptr) % 64 == 0, "alignment failed");
-    buffer_ = static_cast<T*>(ptr);
-    std::cerr << "allocated HUGEPAGE at " << reinterpret_cast<u64>(buffer_)
-              << " with buffer size " << buffer_size << std::endl;
+    if (!(size >= GIGANTIC_PAGE_SIZE && map_huge_pages(PageType::gigantic)) &&
+        !map_huge_pages(PageType::huge)) {
+      map_pages(true);
+    }
 #endif
+    lib_assert(reinterpret_cast<u64>(mapping_) % 64 == 0, "alignment failed");
+    buffer_ = static_cast<T*>(mapping_);
+    bind_to_nic_node();
+
+    std::cerr << "allocated " << get_page_type_name() << " at "
+              << reinterpret_cast<u64>(buffer_) << " with buffer size "
+              << buffer_size << std::endl;
 
     bump_pointer_ = buffer_;
   }
@@ -61,37 +74,185 @@ public:
 
   T* get_full_buffer() const { return buffer_; }
 
-  void deallocate() {
-#ifdef NOHUGEPAGES
-    std::free(buffer_);
-#else
-    munmap(static_cast<void*>(buffer_), buffer_size);
-#endif
-  }
-
-  size_t get_num_hugepages() const {
-    std::ifstream is("/proc/sys/vm/nr_hugepages");
-    size_t num_hugepages;
+  void deallocate() { munmap(mapping_, mapped_size_); }
 
-    lib_assert(is.good(), "Cannot read the number of available hugepages");
-    lib_assert((is >> num_hugepages), "Cannot get the number of hugepages");
+  // number of huge pages of the given size (on the node of the NIC if known),
+  // 0 if the kernel has no such pool
+  static size_t get_num_hugepages(size_t page_size,
+                                  const str& counter = "nr_hugepages") {
+    const i32 node = get_nic_numa_node();
+    const str pool = "hugepages/hugepages-" + std::to_string(page_size >> 10) +
+                     "kB/" + counter;
+    std::ifstream is(node >= 0 ? "/sys/devices/system/node/node" +
+                                   std::to_string(node) + "/" + pool
+                               : "/sys/kernel/mm/" + pool);
+    size_t num_hugepages = 0;
 
-    return num_hugepages;
+    return is >> num_hugepages ? num_hugepages : 0;
   }
 
-  size_t get_memory_size() const {
-#ifdef NOHUGEPAGES
-    return 48UL * 1024UL * 1024UL * 1024UL;  // 48 GB
-#else
-    return get_num_hugepages() * 2048UL * 1024UL;  // 2 MB huge pages
+  // capacity of the huge page pools, the physical memory without huge pages
+  static size_t get_memory_size() {
+#ifndef NOHUGEPAGES
+    const size_t capacity =
+      get_num_hugepages(GIGANTIC_PAGE_SIZE) * GIGANTIC_PAGE_SIZE +
+      get_num_hugepages(HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+    if (capacity > 0) {
+      return capacity;
+    }
 #endif
+    return sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE);
   }
 
   T& operator[](size_t idx) { return *(buffer_ + idx); }
 
+  // faults the pages in with parallel threads, each page is written once
+  // (with its own content, mapped pages are zero-initialized anyway)
   void touch_memory() {
-    for (size_t i = 0; i < buffer_length; ++i) {
-      buffer_[i] = 0;
+    const size_t num_pages = (buffer_size + page_size_ - 1) / page_size_;
+    const u32 num_threads = std::clamp<size_t>(
+      buffer_size / PREFAULT_CHUNK, 1, PREFAULT_THREADS);
+    volatile byte* buffer = reinterpret_cast<byte*>(buffer_);
+
+    const auto prefault = [&](u32 t) {
+      const size_t end_page = num_pages * (t + 1) / num_threads;
+      for (size_t p = num_pages * t / num_threads; p < end_page; ++p) {
+        buffer[p * page_size_] = buffer[p * page_size_];
+      }
+    };
+
+    vec<std::thread> threads;
+    for (u32 t = 1; t < num_threads; ++t) {
+      threads.emplace_back(prefault, t);
+    }
+
+    prefault(0);
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+private:
+  bool map_huge_pages(PageType type) {
+    const bool gigantic = type == PageType::gigantic;
+    const size_t page_size = gigantic ? GIGANTIC_PAGE_SIZE : HUGE_PAGE_SIZE;
+    const size_t size = (buffer_size + page_size - 1) / page_size * page_size;
+
+    if (get_num_hugepages(page_size, "free_hugepages") < size / page_size) {
+      return false;
+    }
+
+    void* ptr = mmap(nullptr,
+                     size,
+                     PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+                       ((gigantic ? 30 : 21) << MAP_HUGE_SHIFT),
+                     -1,
+                     0);
+    if (ptr == MAP_FAILED) {
+      return false;
+    }
+
+    set_mapping(ptr, size, page_size, type);
+    return true;
+  }
+
+  // normal pages aligned to 2MB s.t. the kernel can back them with
+  // transparent huge pages (if enabled)
+  void map_pages(bool transparent) {
+    const size_t size =
+      (buffer_size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    byte* ptr = static_cast<byte*>(mmap(nullptr,
+                                        size + HUGE_PAGE_SIZE,
+                                        PROT_READ | PROT_WRITE,
+                                        MAP_PRIVATE | MAP_ANONYMOUS,
+                                        -1,
+                                        0));
+    lib_assert(ptr != MAP_FAILED, "Allocating memory failed");
+
+    // unmap the unaligned head and the remaining tail
+    byte* aligned = reinterpret_cast<byte*>(
+      (reinterpret_cast<u64>(ptr) + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE *
+      HUGE_PAGE_SIZE);
+    if (aligned > ptr) {
+      munmap(ptr, aligned - ptr);
+    }
+    munmap(aligned + size, ptr + HUGE_PAGE_SIZE - aligned);
+
+    transparent = transparent && madvise(aligned, size, MADV_HUGEPAGE) == 0;
+    set_mapping(aligned,
+                size,
+                sysconf(_SC_PAGESIZE),
+                transparent ? PageType::transparent : PageType::normal);
+  }
+
+  void set_mapping(void* ptr, size_t size, size_t page_size, PageType type) {
+    mapping_ = ptr;
+    mapped_size_ = size;
+    page_size_ = page_size;
+    page_type_ = type;
+  }
+
+  // before any page is faulted in
+  void bind_to_nic_node() {
+    const i32 node = get_nic_numa_node();
+    if (node < 0) {
+      return;
+    }
+
+    const u64 node_mask = 1ul << node;
+    if (syscall(SYS_mbind,
+                mapping_,
+                mapped_size_,
+                MPOL_BIND,
+                &node_mask,
+                sizeof(node_mask) * 8,
+                0) != 0) {
+      std::cerr << "cannot bind memory to NUMA node " << node << std::endl;
+    }
+  }
+
+  // node of the first InfiniBand device (-1 if there is none or it is unknown)
+  static i32 get_nic_numa_node() {
+    static const i32 node = [] {
+      DIR* dir = opendir("/sys/class/infiniband");
+      if (dir == nullptr) {
+        return -1;
+      }
+
+      vec<str> devices;
+      for (dirent* entry = readdir(dir); entry; entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+          devices.emplace_back(entry->d_name);
+        }
+      }
+      closedir(dir);
+
+      if (devices.empty()) {
+        return -1;
+      }
+
+      std::sort(devices.begin(), devices.end());
+      std::ifstream is("/sys/class/infiniband/" + devices.front() +
+                       "/device/numa_node");
+      i32 numa_node = -1;
+
+      return is >> numa_node ? numa_node : -1;
+    }();
+
+    return node;
+  }
+
+  str get_page_type_name() const {
+    switch (page_type_) {
+      case PageType::gigantic:
+        return "1GB HUGEPAGES";
+      case PageType::huge:
+        return "2MB HUGEPAGES";
+      case PageType::transparent:
+        return "TRANSPARENT HUGEPAGES";
+      default:
+        return "NORMAL PAGES";
     }
   }
 
@@ -103,6 +264,11 @@ private:
   T* buffer_{nullptr};
   void* bump_pointer_{nullptr};
   size_t size_left_{0};
+
+  void* mapping_{nullptr};
+  size_t mapped_size_{0};
+  size_t page_size_{0};  // stride of touch_memory
+  PageType page_type_{PageType::normal};
 };
 
 #endif  // RDMA_LIBRARY_HUGEPAGE_HH
@@ -308,13 +308,14 @@ void QueuePair::post_CAS(MemoryRegion& local_region,
                          u64 compare_to,
                          u64 swap_with,
                          bool signaled,
-                         u64 wr_id) {
+                         u64 wr_id,
+                         u64 local_offset) {
   ibv_send_wr work_request{};
   ibv_sge sge{};
 
   struct ibv_send_wr* bad_work_request;
 
-  sge.addr = local_region.get_address();
+  sge.addr = local_region.get_address() + local_offset;
   sge.length = 8;
   sge.lkey = local_region.get_lkey();
 
@@ -335,3 +336,35 @@ void QueuePair::post_CAS(MemoryRegion& local_region,
   lib_assert(ibv_post_send(queue_pair_, &work_request, &bad_work_request) == 0,
              "Cannot post CAS request");
 }
+
+void QueuePair::post_FAA(MemoryRegion& local_region,
+                         MemoryRegionToken* remote_token,
+                         u64 remote_offset,
+                         u64 add,
+                         bool signaled,
+                         u64 wr_id) {
+  ibv_send_wr work_request{};
+  ibv_sge sge{};
+
+  struct ibv_send_wr* bad_work_request;
+
+  sge.addr = local_region.get_address();
+  sge.length = 8;
+  sge.lkey = local_region.get_lkey();
+
+  work_request.opcode = IBV_WR_ATOMIC_FETCH_AND_ADD;
+  work_request.send_flags = signaled ? IBV_SEND_SIGNALED : 0;
+  work_request.wr_id = wr_id;
+  work_request.next = nullptr;
+  work_request.sg_list = &sge;
+  work_request.num_sge = 1;
+
+  auto& atomic = work_request.wr.atomic;
+  atomic.remote_addr = remote_token->address + remote_offset;
+  atomic.rkey = remote_token->rkey;
+
+  atomic.compare_add = add;
+
+  lib_assert(ibv_post_send(queue_pair_, &work_request, &bad_work_request) == 0,
+             "Cannot post FAA request");
+}
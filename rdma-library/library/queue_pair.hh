@@ -95,6 +95,14 @@ public:
                 u64 compare_to,
                 u64 swap_with,
                 bool signaled = true,
+                u64 wr_id = 0,
+                u64 local_offset = 0);
+
+  void post_FAA(MemoryRegion& local_region,
+                MemoryRegionToken* remote_token,
+                u64 remote_offset,
+                u64 add,
+                bool signaled = true,
                 u64 wr_id = 0);
 
 private:
@@ -0,0 +1,25 @@
+#!/bin/bash
+
+# Compares the READ bytes per query of dynamic_block_index for different
+# numbers of cached blocks (--cache-blocks), e.g., with a Zipfian read-mostly
+# query file.
+
+source "$(dirname "$0")/common.sh"
+check_usage $# 6 "<executable> <index-dir> <query-file> <servers> <threads> <block-size> [clients]"
+
+executable=$1
+index_dir=$2
+query_file=$3
+servers=$4
+threads=$5
+block_size=$6
+clients=${7:-}
+
+echo "cache_blocks,queries_per_sec,read_bytes_per_query,cache_hits,cache_stale"
+
+for cache_blocks in 0 10000 100000; do
+  run_compute_node "$executable" "$index_dir" --query-file "$query_file" \
+    --cache-blocks $cache_blocks |
+    print_stats "$cache_blocks" queries_per_sec read_bytes_per_query \
+      cache_hits cache_stale
+done
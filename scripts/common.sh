@@ -0,0 +1,43 @@
+#!/bin/bash
+
+# Shared by the benchmark scripts, to be sourced after setting their arguments.
+
+script_dir=$(dirname "${BASH_SOURCE[0]}")
+
+# check_usage <num-args> <min-args> <usage>
+check_usage() {
+  if [ "$1" -lt "$2" ]; then
+    echo "usage: $0 $3"
+    exit 1
+  fi
+}
+
+# run_compute_node <executable> <index-dir> [options...]
+# runs an initiating compute node with the $servers, $threads, $block_size and
+# (optional) $clients of the calling script and prints its stats.
+# The memory nodes (and the remaining compute nodes) must be started for
+# every run, e.g., in a loop with the same number of iterations.
+run_compute_node() {
+  local client_args=()
+  if [ -n "$clients" ]; then
+    client_args=(--clients $clients)
+  fi
+
+  numactl --membind=1 "$1" --initiator --index-dir "$2" \
+    --servers $servers "${client_args[@]}" --threads "$threads" \
+    --operation intersection --block-size "$block_size" "${@:3}" 2>/dev/null
+}
+
+# run_memory_node <executable> [options...]
+# runs a memory node and prints its timings.
+# The compute nodes must be started after each memory node start.
+run_memory_node() {
+  numactl --membind=1 --cpunodebind=1 "$1" --is-server "${@:2}" 2>/dev/null
+}
+
+# print_stats <columns> <stat>...
+# prints the given columns followed by the given stats of the JSON on stdin
+# (see extract_stats.py) as one CSV row
+print_stats() {
+  echo "$1,$(python3 "$script_dir/extract_stats.py" "${@:2}")"
+}
@@ -0,0 +1,25 @@
+#!/bin/bash
+
+# Compares the throughput and the retries of contended CASs of
+# dynamic_block_index for different maximum backoffs (--backoff-ns), e.g.,
+# with a write-heavy query file on few (Zipfian) terms.
+
+source "$(dirname "$0")/common.sh"
+check_usage $# 6 "<executable> <index-dir> <query-file> <servers> <threads> <block-size> [clients]"
+
+executable=$1
+index_dir=$2
+query_file=$3
+servers=$4
+threads=$5
+block_size=$6
+clients=${7:-}
+
+echo "backoff_ns,queries_per_sec,locking_failed,backoff_time_us,lock_retries,free_list_retries"
+
+for backoff_ns in 0 1000 10000 100000; do
+  run_compute_node "$executable" "$index_dir" --query-file "$query_file" \
+    --backoff-ns $backoff_ns |
+    print_stats "$backoff_ns" queries_per_sec locking_failed backoff_time_us \
+      lock_retries free_list_retries
+done
@@ -0,0 +1,28 @@
+#!/bin/bash
+
+# Compares the validation of dynamic blocks with cache-line versions and with a
+# CRC32C: the first executable and index directory must be built without,
+# the second ones with -DCRC_BLOCKS (partitioned with the respective build).
+# The memory nodes must be started with the build of the respective run.
+# The validations are timed in both runs (which slows down their READs).
+
+source "$(dirname "$0")/common.sh"
+check_usage $# 8 "<versions-executable> <versions-index-dir> <crc-executable> <crc-index-dir> <query-file> <servers> <threads> <block-size> [clients]"
+
+executables=("$1" "$3")
+index_dirs=("$2" "$4")
+query_file=$5
+servers=$6
+threads=$7
+block_size=$8
+clients=${9:-}
+
+echo "block_validation,block_capacity,queries_per_sec,read_bytes_per_query,validated_blocks,validation_ns_per_block"
+
+for i in 0 1; do
+  run_compute_node "${executables[$i]}" "${index_dirs[$i]}" \
+    --query-file "$query_file" --time-validation |
+    python3 "$script_dir/extract_stats.py" meta.block_validation \
+      meta.block_capacity queries_per_sec read_bytes_per_query \
+      validated_blocks validation_ns_per_block
+done
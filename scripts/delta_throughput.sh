@@ -0,0 +1,29 @@
+#!/bin/bash
+
+# Reports the throughput and the read overhead of dynamic_block_index for
+# increasing capacities of the per-term delta logs (--delta-entries), 0 applies
+# the inserts in place.
+# The query file should mix inserts and reads (deletes are not supported with
+# delta logs).
+
+source "$(dirname "$0")/common.sh"
+check_usage $# 6 "<executable> <index-dir> <query-file> <servers> <threads> <block-size> [clients]"
+
+executable=$1
+index_dir=$2
+query_file=$3
+servers=$4
+threads=$5
+block_size=$6
+clients=${7:-}
+
+capacities="0 64 256 1024"
+
+echo "delta_entries,queries_per_sec,rdma_reads_in_bytes,delta_reads_in_bytes,delta_appends,delta_full,compacted_entries"
+
+for c in $capacities; do
+  run_compute_node "$executable" "$index_dir" --query-file "$query_file" \
+    --delta-entries "$c" |
+    print_stats "$c" queries_per_sec rdma_reads_in_bytes \
+      delta_reads_in_bytes delta_appends delta_full compacted_entries
+done
@@ -0,0 +1,39 @@
+#!/bin/bash
+
+# Converts the lists of dynamic_block_index (after the given queries) into the
+# read-only block layout of block_index: the lists are exported with
+# --export-file and partitioned with the strategy "block".
+# The memory nodes (and the remaining compute nodes) must be started as well.
+
+if [ "$#" -lt 8 ]; then
+  echo "usage: $0 <executable> <partitioner> <index-dir> <query-file> <servers> <threads> <block-size> <output-path> [clients]"
+  exit 1
+fi
+
+executable=$1
+partitioner=$2
+index_dir=$3
+query_file=$4
+servers=$5
+threads=$6
+block_size=$7
+output_path=$8
+clients=${9:-}
+
+export_file="$output_path/exported_lists.dat"
+
+client_args=()
+if [ -n "$clients" ]; then
+  client_args=(--clients $clients)
+fi
+
+numactl --membind=1 "$executable" --initiator \
+  --index-dir "$index_dir" --query-file "$query_file" \
+  --servers $servers "${client_args[@]}" --threads "$threads" \
+  --operation intersection --block-size "$block_size" \
+  --export-file "$export_file" || exit 1
+
+"$partitioner" -i "$export_file" -o "$output_path" -s block \
+  -n $servers -b "$block_size" || exit 1
+
+rm "$export_file"
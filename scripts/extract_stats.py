@@ -0,0 +1,26 @@
+import sys
+import json
+
+
+# prints the given stats of the JSON on stdin as one CSV row, nested stats are
+# addressed by dots (e.g., meta.block_capacity), histograms are joined by "|",
+# missing stats are printed as the default after "=" (or empty)
+def extract(stats, name):
+    path, _, default = name.partition("=")
+    value = stats
+    for key in path.split("."):
+        if not isinstance(value, dict) or key not in value:
+            return default
+        value = value[key]
+
+    if isinstance(value, list):
+        return "|".join(map(str, value))
+    return str(value)
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        sys.exit(f"usage: ./{sys.argv[0]} <stat> [stat...] < stats.json")
+
+    stats = json.load(sys.stdin)
+    print(",".join(extract(stats, name) for name in sys.argv[1:]))
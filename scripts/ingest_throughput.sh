@@ -0,0 +1,40 @@
+#!/bin/bash
+
+# Compares ingesting documents (e.g., the 5% drawn by
+# draw_documents_and_create_index) into dynamic_block_index with insert queries
+# (one query per document) and with a bulk ingest (--ingest-file).
+# The bulk ingest is followed by the given read queries.
+
+source "$(dirname "$0")/common.sh"
+check_usage $# 7 "<executable> <index-dir> <documents-to-insert-file> <read-query-file> <servers> <threads> <block-size> [clients]"
+
+executable=$1
+index_dir=$2
+docs_to_insert=$3
+read_queries=$4
+servers=$5
+threads=$6
+block_size=$7
+clients=${8:-}
+
+workload_dir=$(mktemp -d)
+insert_queries="$workload_dir/inserts.txt"
+sed 's/^\([0-9]*\):/i: \1/' "$docs_to_insert" > "$insert_queries"
+
+num_documents=$(wc -l < "$docs_to_insert")
+num_postings=$(awk '{ n += NF - 1 } END { print n }' "$docs_to_insert")
+
+echo "mode,documents_per_sec,rdma_writes_in_bytes,insert_commits"
+
+run_compute_node "$executable" "$index_dir" --query-file "$insert_queries" |
+  print_stats inserts queries_per_sec rdma_writes_in_bytes insert_commits
+
+# converts the ingested postings per second to documents per second
+run_compute_node "$executable" "$index_dir" --query-file "$read_queries" \
+  --ingest-file "$docs_to_insert" |
+  print_stats bulk ingest_postings_per_sec rdma_writes_in_bytes \
+    insert_commits |
+  awk -F, -v OFS=, -v docs="$num_documents" -v postings="$num_postings" \
+    '{ $2 = int($2 * docs / postings) } 1'
+
+rm -r "$workload_dir"
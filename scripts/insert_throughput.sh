@@ -0,0 +1,38 @@
+#!/bin/bash
+
+# Measures the query throughput of dynamic_block_index for mixed workloads
+# (created with mix_queries.py) and different insert batch sizes.
+
+source "$(dirname "$0")/common.sh"
+check_usage $# 8 "<executable> <index-dir> <read-query-file> <documents-to-insert-file> <num-queries> <servers> <threads> <block-size> [clients]"
+
+executable=$1
+index_dir=$2
+read_queries=$3
+docs_to_insert=$4
+num_queries=$5
+servers=$6
+threads=$7
+block_size=$8
+clients=${9:-}
+
+insert_percentages="10 50 90"
+batch_sizes="1 16 256 4096"
+
+workload_dir=$(mktemp -d)
+
+echo "insert_percentage,insert_batch,queries_per_sec,insert_commits"
+
+for p in $insert_percentages; do
+  query_file="$workload_dir/mixed_$p.txt"
+  python3 "$script_dir/mix_queries.py" "$read_queries" "$docs_to_insert" \
+    "$query_file" "$p" "$num_queries"
+
+  for b in $batch_sizes; do
+    run_compute_node "$executable" "$index_dir" --query-file "$query_file" \
+      --insert-batch "$b" |
+      print_stats "$p,$b" queries_per_sec insert_commits
+  done
+done
+
+rm -r "$workload_dir"
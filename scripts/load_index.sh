@@ -0,0 +1,18 @@
+#!/bin/bash
+
+# Measures the time a memory node takes to load its index file into memory
+# for different numbers of parallel I/O streams.
+
+source "$(dirname "$0")/common.sh"
+check_usage $# 2 "<executable> <num-clients>"
+
+executable=$1
+num_clients=$2
+
+echo "io_streams,read_index_into_memory_ms"
+
+for io_streams in 1 2 4 8; do
+  run_memory_node "$executable" --num-clients $num_clients \
+    --io-streams $io_streams |
+    print_stats "$io_streams" read_index_into_memory
+done
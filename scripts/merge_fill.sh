@@ -0,0 +1,25 @@
+#!/bin/bash
+
+# Compares the fill factor and the READ bytes per query of dynamic_block_index
+# for different merge fills (--merge-fill), the query file should contain the
+# inserts that split blocks (and deletes) followed by read queries.
+
+source "$(dirname "$0")/common.sh"
+check_usage $# 6 "<executable> <index-dir> <query-file> <servers> <threads> <block-size> [clients]"
+
+executable=$1
+index_dir=$2
+query_file=$3
+servers=$4
+threads=$5
+block_size=$6
+clients=${7:-}
+
+echo "merge_fill,queries_per_sec,read_bytes_per_query,fill_factor_before,fill_factor_after,merged_blocks"
+
+for merge_fill in 0 70 90; do
+  run_compute_node "$executable" "$index_dir" --query-file "$query_file" \
+    --merge-fill $merge_fill |
+    print_stats "$merge_fill" queries_per_sec read_bytes_per_query \
+      fill_factor_before fill_factor_after merged_blocks
+done
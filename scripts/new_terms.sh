@@ -0,0 +1,24 @@
+#!/bin/bash
+
+# Measures the throughput of dynamic_block_index for a query file that inserts
+# terms without a list in the meta files (--max-terms must exceed the largest
+# term of the query file).
+
+source "$(dirname "$0")/common.sh"
+check_usage $# 7 "<executable> <index-dir> <query-file> <servers> <threads> <block-size> <max-terms> [clients]"
+
+executable=$1
+index_dir=$2
+query_file=$3
+servers=$4
+threads=$5
+block_size=$6
+max_terms=$7
+clients=${8:-}
+
+echo "max_terms,queries_per_sec,created_heads,catalog_pulls,catalog_size"
+
+run_compute_node "$executable" "$index_dir" --query-file "$query_file" \
+  --max-terms $max_terms |
+  print_stats "$max_terms" queries_per_sec created_heads catalog_pulls \
+    catalog_size
@@ -0,0 +1,45 @@
+#!/bin/bash
+
+# Compares the insert throughput of dynamic_block_index with and without term
+# ownership (--own-terms) for insert workloads of increasing Zipfian term skew
+# (created with zipf_inserts.py).
+
+source "$(dirname "$0")/common.sh"
+check_usage $# 9 "<executable> <index-dir> <num-queries> <universe-size> <first-doc-id> <servers> <threads> <block-size> <terms-per-insert> [clients]"
+
+executable=$1
+index_dir=$2
+num_queries=$3
+universe_size=$4
+first_doc_id=$5
+servers=$6
+threads=$7
+block_size=$8
+terms_per_insert=$9
+clients=${10:-}
+
+exponents="0 0.5 0.99 1.2"
+
+workload_dir=$(mktemp -d)
+
+echo "zipf_exponent,own_terms,queries_per_sec,locking_failed,block_repeated_reads,forwarded_updates"
+
+for e in $exponents; do
+  query_file="$workload_dir/zipf_$e.txt"
+  python3 "$script_dir/zipf_inserts.py" "$query_file" "$num_queries" \
+    "$universe_size" "$terms_per_insert" "$e" "$first_doc_id"
+
+  for own in false true; do
+    own_args=()
+    if [ "$own" = true ]; then
+      own_args=(--own-terms)
+    fi
+
+    run_compute_node "$executable" "$index_dir" --query-file "$query_file" \
+      "${own_args[@]}" |
+      print_stats "$e,$own" queries_per_sec locking_failed \
+        block_repeated_reads forwarded_updates
+  done
+done
+
+rm -r "$workload_dir"
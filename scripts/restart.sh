@@ -0,0 +1,26 @@
+#!/bin/bash
+
+# Measures the startup of a dynamic_block_index memory node from its index
+# file (writing a snapshot once the compute nodes are done) and from the
+# snapshot of the previous run.
+
+source "$(dirname "$0")/common.sh"
+check_usage $# 3 "<executable> <snapshot-dir> <num-clients>"
+
+executable=$1
+snapshot_dir=$2
+num_clients=$3
+
+echo "start,read_index_into_memory_ms,read_snapshot_ms,write_snapshot_ms"
+
+for start in index snapshot; do
+  restore_args=()
+  if [ "$start" == "snapshot" ]; then
+    restore_args=(--restore)
+  fi
+
+  run_memory_node "$executable" --num-clients $num_clients \
+    --snapshot-dir "$snapshot_dir" "${restore_args[@]}" |
+    print_stats "$start" read_index_into_memory=0 read_snapshot=0 \
+      write_snapshot=0
+done
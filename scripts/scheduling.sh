@@ -0,0 +1,25 @@
+#!/bin/bash
+
+# Compares the read and write latencies of the scheduling policies
+# (--scheduling) for a mixed query file of reads and inserts, e.g., created
+# with mix_queries.py.
+
+source "$(dirname "$0")/common.sh"
+check_usage $# 6 "<executable> <index-dir> <query-file> <servers> <threads> <block-size> [clients]"
+
+executable=$1
+index_dir=$2
+query_file=$3
+servers=$4
+threads=$5
+block_size=$6
+clients=${7:-}
+
+echo "scheduling,queries_per_sec,read_p50_us,read_p99_us,write_p50_us,write_p99_us"
+
+for scheduling in fifo priority weighted dedicated; do
+  run_compute_node "$executable" "$index_dir" --query-file "$query_file" \
+    --scheduling $scheduling |
+    print_stats "$scheduling" queries_per_sec read_latency_us.p50 \
+      read_latency_us.p99 write_latency_us.p50 write_latency_us.p99
+done
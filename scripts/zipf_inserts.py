@@ -0,0 +1,29 @@
+import sys
+import numpy as np
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 7:
+        sys.exit(f"usage: ./{sys.argv[0]} <output-file> <num-queries> <universe-size> <terms-per-insert> <zipf-exponent> <first-doc-id>")
+
+    output_file = str(sys.argv[1])
+    num_queries = int(sys.argv[2])
+    universe_size = int(sys.argv[3])
+    terms_per_insert = int(sys.argv[4])
+    exponent = float(sys.argv[5])
+    first_doc_id = int(sys.argv[6])
+
+    assert terms_per_insert <= universe_size
+
+    # term of rank k is drawn with probability proportional to 1 / k^exponent
+    # (exponent 0 is uniform), ranks are shuffled across the term ids
+    rng = np.random.default_rng()
+    weights = 1.0 / np.power(np.arange(1, universe_size + 1), exponent)
+    probabilities = weights / weights.sum()
+    terms = rng.permutation(universe_size) + 1
+
+    with open(output_file, "w") as f:
+        for i in range(num_queries):
+            ranks = rng.choice(universe_size, size=terms_per_insert, replace=False, p=probabilities)
+            doc = sorted(terms[ranks])
+            f.write(f"i: {first_doc_id + i} {' '.join(map(str, doc))}\n")
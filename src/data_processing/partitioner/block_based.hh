@@ -1,27 +1,33 @@
 #ifndef DATA_PROCESSING_PARTITIONER_BLOCK_BASED_HH
 #define DATA_PROCESSING_PARTITIONER_BLOCK_BASED_HH
 
+#include <algorithm>
 #include <library/types.hh>
 
 #include "data_processing/serializer/deserializer.hh"
 #include "index/block_based_dynamic/remote_pointer.hh"
 #include "index/crc.hh"
+#include "index/crc32c.hh"
 
 namespace partitioner {
 
 // meta data:  [ memory node | universe | num init blocks | block size |
 //               term1 | offset | ... ]
 // index data: [ block[entries... | r_ptr] | ... ]
-//               every cache line is versioned
+//               every cache line is versioned (the version slot of the
+//               last cache line holds the range of the last WRITE)
 // footer:
 //  * read-only footer:
 //     remote ptr (64): [ memory node | offset ]
 //                      (32bit offset is sufficient since we address blocks)
 //  * updates footer:
 //     remote ptr (64): [ p_tag (16) | m_id (10) | offset(38) ]
-//     flags (64):      [ cl version (32) | null (14) | b_tag (16) | lock (1) ]
+//     flags (64):      [ cl version (32) | fill (15) | b_tag (16) | lock (1) ]
 //     (the last 64bit word is accessed with CAS, must be one word and
 //      interpreted as 64bit word!!!, with the version we can detect changes)
+//  * crc footer (CRC_BLOCKS, no cache line versions):
+//     crc (64):        [ crc32c (32) | covered entries (32) ]
+//     followed by the updates footer, the crc covers the entries and r_ptr
 class BlockBasedPartitioner {
 private:
   using Batch = vec<u32>;
@@ -29,6 +35,8 @@ private:
   constexpr static u32 CACHE_LINE_SIZE = 64;
   constexpr static u32 INIT_CACHE_LINE_VERSION = 0;
   constexpr static u32 INIT_BLOCK_TAG = 0;
+  constexpr static bool CACHE_LINE_VERSIONS =
+    inv_index::block_based::CACHE_LINE_VERSIONS;
 
 public:
   BlockBasedPartitioner(vec<Batch>& meta_batches,
@@ -39,23 +47,37 @@ public:
         num_nodes_(num_nodes) {}
 
 private:
+  // the block's entries (including tombstones) precede the footer
   static void add_footer(Batch& batch,
                          u32 next_node,
                          u32 next_offset,
-                         bool updates) {
+                         bool updates,
+                         u32 num_entries) {
     // remote ptr (64): [ p_tag (16) | m_id (10) | offset(38) ]
-    //     flags (64):  [ cl version (32) | null (14) | b_tag (16) | lock (1) ]
+    //     flags (64):  [ cl version (32) | fill (15) | b_tag (16) | lock (1) ]
     if (updates) {
       const u64 r_ptr =
         inv_index::block_based::dynamic::RemotePtr::encode_remote_ptr(
           INIT_BLOCK_TAG, next_node, next_offset);
+      const u32 r_ptr_words[2] = {static_cast<u32>(r_ptr >> 32),
+                                  static_cast<u32>((r_ptr << 32) >> 32)};
+
+      if constexpr (!CACHE_LINE_VERSIONS) {
+        const u32* entries = batch.data() + batch.size() - num_entries;
+        const u32 covered =
+          std::find(entries, entries + num_entries, TOMBSTONE) - entries;
+
+        const u32 crc = crc32c(entries, covered * sizeof(u32));
+        batch.push_back(crc32c(r_ptr_words, sizeof(r_ptr_words), crc));
+        batch.push_back(covered);
+      }
 
       // split r_ptr in two single words
-      batch.push_back(r_ptr >> 32);
-      batch.push_back((r_ptr << 32) >> 32);
+      batch.push_back(r_ptr_words[0]);
+      batch.push_back(r_ptr_words[1]);
 
-      // [ cache line version (32) | null (14) | b_tag (16) |lock-bit (1) ]
-      // b_tag starts with 0, free and lock are not set
+      // [ cache line version (32) | fill (15) | b_tag (16) |lock-bit (1) ]
+      // b_tag starts with 0, fill count and lock are not set
       batch.push_back(INIT_CACHE_LINE_VERSION);
       batch.push_back(0);
 
@@ -73,12 +95,13 @@ public:
                  vec<u32>& accessed,
                  bool updates,
                  const func<void(u32)>& print_status) {
-    const u32 remote_ptr_entries = updates ? 4 : 2;
+    const u32 remote_ptr_entries =
+      updates ? inv_index::block_based::DYNAMIC_FOOTER_SIZE / sizeof(u32) : 2;
     //                 const func<void(u32)>& write_output) {
     const u32 block_entries = block_size / sizeof(u32);
     const bool accessed_only = !accessed.empty();
-    name_ =
-      (updates ? "dynamic_" : "") + str("block") + std::to_string(block_size);
+    const str prefix = CACHE_LINE_VERSIONS ? "dynamic_" : "dynamic_crc_";
+    name_ = (updates ? prefix : "") + str("block") + std::to_string(block_size);
 
     for (Batch& meta_batch : meta_batches_) {
       meta_batch.push_back(block_size);
@@ -136,9 +159,8 @@ public:
       ++num_blocks;
 
       const auto cache_line_versioning = [&]() {
-        if (updates && (block_size - remaining_block_entries * sizeof(u32)) %
-                           CACHE_LINE_SIZE ==
-                         0) {
+        const u32 used = block_size - remaining_block_entries * sizeof(u32);
+        if (updates && CACHE_LINE_VERSIONS && used % CACHE_LINE_SIZE == 0) {
           --remaining_block_entries;
           index_batches_[node].push_back(INIT_CACHE_LINE_VERSION);
         }
@@ -155,7 +177,11 @@ public:
           const u32 next_node = (node + 1) % num_nodes_;
           u32& next_offset = offset_per_memory_node[next_node];
 
-          add_footer(index_batches_[node], next_node, next_offset, updates);
+          add_footer(index_batches_[node],
+                     next_node,
+                     next_offset,
+                     updates,
+                     block_entries - remote_ptr_entries);
           ++next_offset;
 
           node = next_node;
@@ -178,7 +204,11 @@ public:
 
       // set null pointer
       if (remaining_block_entries > 0) {
-        add_footer(index_batches_[node], 0, 0, updates);
+        add_footer(index_batches_[node],
+                   0,
+                   0,
+                   updates,
+                   block_entries - remote_ptr_entries);
         remaining_block_entries -= remote_ptr_entries;
       }
     }
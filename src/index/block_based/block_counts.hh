@@ -0,0 +1,36 @@
+#ifndef INDEX_BLOCK_BASED_BLOCK_COUNTS_HH
+#define INDEX_BLOCK_BASED_BLOCK_COUNTS_HH
+
+#include <algorithm>
+#include <library/types.hh>
+
+namespace inv_index::block_based {
+
+// global position of a block: the partitioner deals out blocks round-robin,
+// i.e., block g is stored on memory node g % n at offset g / n
+inline u64 global_block_position(u32 memory_node,
+                                 u32 offset,
+                                 u32 num_servers) {
+  return static_cast<u64>(offset) * num_servers + memory_node;
+}
+
+// estimates the number of blocks per list from the positions of the head
+// blocks (pairs of global position and term): a list spans all blocks until
+// the next head (exact unless only the accessed lists have been partitioned)
+inline vec<u32> estimate_block_counts(vec<std::pair<u64, u32>>& heads,
+                                      size_t universe_size) {
+  std::sort(heads.begin(), heads.end());
+  vec<u32> block_counts(universe_size, 0);
+
+  for (size_t i = 0; i < heads.size(); ++i) {
+    const u64 next =
+      i + 1 < heads.size() ? heads[i + 1].first : heads[i].first + 1;
+    block_counts[heads[i].second] = static_cast<u32>(next - heads[i].first);
+  }
+
+  return block_counts;
+}
+
+}  // namespace inv_index::block_based
+
+#endif  // INDEX_BLOCK_BASED_BLOCK_COUNTS_HH
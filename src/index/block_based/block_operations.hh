@@ -1,6 +1,7 @@
 #ifndef INDEX_BLOCK_BASED_BLOCK_OPERATIONS_HH
 #define INDEX_BLOCK_BASED_BLOCK_OPERATIONS_HH
 
+#include <algorithm>
 #include <library/types.hh>
 
 #include "read_buffer.hh"
@@ -17,9 +18,9 @@ void block_intersection(const func<void(u32)>& result_handler,
   using BufferBlock = typename ReadBuffer<cache_line_versions>::BufferBlock;
 
   const u32 tombstone = static_cast<u32>(-1);
-  const u32 footer_size = cache_line_versions ? 4 : 2;
-  const u32 block_entries = read_buffer.block_size / sizeof(u32) - footer_size;
-  const u32 init_pos = cache_line_versions ? 1 : 0;
+  const u32 block_entries =
+    read_buffer.block_size / sizeof(u32) - BufferBlock::footer_length;
+  const u32 init_pos = BufferBlock::first_position;
 
   if (query_length == 0) {
     return;
@@ -47,11 +48,9 @@ void block_intersection(const func<void(u32)>& result_handler,
 
       while (pos < block_entries && current_block->buffer[pos] != tombstone) {
         // skip cache line versions
-        if constexpr (cache_line_versions) {
-          if ((pos * sizeof(u32)) % CACHE_LINE_SIZE == 0) {
-            ++pos;
-            continue;
-          }
+        if (BufferBlock::is_version_slot(pos)) {
+          ++pos;
+          continue;
         }
 
         result_handler(current_block->buffer[pos]);
@@ -109,8 +108,7 @@ void block_intersection(const func<void(u32)>& result_handler,
 
     while (current_pos < block_entries &&
            // either current_pos hits a cache line version
-           ((cache_line_versions &&
-             (current_pos * sizeof(u32)) % CACHE_LINE_SIZE == 0) ||
+           (BufferBlock::is_version_slot(current_pos) ||
             // or the following must hold to advance the position
             (current_block->buffer[current_pos] != tombstone &&
              current_block->buffer[current_pos] < current_value))) {
@@ -140,11 +138,9 @@ void block_intersection(const func<void(u32)>& result_handler,
       ++current_pos;
 
       // skip cache line versions
-      if constexpr (cache_line_versions) {
-        if (current_pos != block_entries &&
-            (current_pos * sizeof(u32)) % CACHE_LINE_SIZE == 0) {
-          ++current_pos;
-        }
+      if (current_pos != block_entries &&
+          BufferBlock::is_version_slot(current_pos)) {
+        ++current_pos;
       }
 
       // match found
@@ -197,6 +193,117 @@ void block_intersection(const func<void(u32)>& result_handler,
   }
 }
 
+// intersection of dynamic lists whose recent inserts are (partially) still
+// in delta logs, the ordered and unique delta entries of list col are merged
+// on the fly with its block chain (an entry may be in both)
+inline void block_intersection_with_deltas(
+  const func<void(u32)>& result_handler,
+  const func<void()>& poll,
+  const func<void(u32, u32, u32, u32)>& post_READ,
+  ReadBuffer<true>& read_buffer,
+  const vec<vec<u32>>& deltas,
+  u32 query_length) {
+  using BufferBlock = ReadBuffer<true>::BufferBlock;
+
+  struct Cursor {
+    u32 row{0};
+    u32 pos{BufferBlock::first_position};
+    BufferBlock* block{nullptr};
+    size_t delta_pos{0};
+  };
+
+  const u32 tombstone = static_cast<u32>(-1);
+  const u32 block_entries =
+    read_buffer.block_size / sizeof(u32) - BufferBlock::footer_length;
+
+  if (query_length == 0) {
+    return;
+  }
+
+  vec<Cursor> cursors(query_length);
+
+  // waits for the current block of list col and READs its successor
+  const auto enter_block = [&](u32 col) {
+    Cursor& c = cursors[col];
+    c.block = &read_buffer.get_block(col, c.row);
+
+    while (!c.block->is_ready()) {
+      poll();
+    }
+
+    if (!c.block->points_to_null()) {
+      auto [memory_node, offset] = c.block->get_remote_ptr();
+      u32 next_row = (c.row + 1) % inv_index::block_based::READ_BUFFER_DEPTH;
+      post_READ(col, next_row, memory_node, offset);
+    }
+  };
+
+  // smallest entry >= value of list col, tombstone if there is none
+  const auto seek = [&](u32 col, u32 value) -> u32 {
+    Cursor& c = cursors[col];
+    u32 block_value;
+
+    while (true) {
+      if (c.pos < block_entries && BufferBlock::is_version_slot(c.pos)) {
+        ++c.pos;  // skip cache line versions
+        continue;
+      }
+
+      block_value = c.pos < block_entries ? c.block->buffer[c.pos] : tombstone;
+      if (block_value != tombstone && block_value < value) {
+        ++c.pos;
+        continue;
+      }
+
+      // end of the block
+      if (block_value == tombstone && !c.block->points_to_null()) {
+        c.row = (c.row + 1) % inv_index::block_based::READ_BUFFER_DEPTH;
+        c.pos = BufferBlock::first_position;
+        enter_block(col);
+        continue;
+      }
+
+      break;
+    }
+
+    const vec<u32>& delta = deltas[col];
+    while (c.delta_pos < delta.size() && delta[c.delta_pos] < value) {
+      ++c.delta_pos;
+    }
+
+    const u32 delta_value =
+      c.delta_pos < delta.size() ? delta[c.delta_pos] : tombstone;
+    return std::min(block_value, delta_value);
+  };
+
+  for (u32 col = 0; col < query_length; ++col) {
+    enter_block(col);
+  }
+
+  // leapfrog over the lists, value is the candidate matched by count lists
+  u32 col = 0, count = 1;
+  u32 current_value = seek(col, 0);
+
+  while (current_value != tombstone) {
+    if (count == query_length) {
+      result_handler(current_value);
+      current_value = seek(col, current_value + 1);
+      count = 1;
+      continue;
+    }
+
+    col = (col + 1) % query_length;
+    const u32 value = seek(col, current_value);
+
+    if (value == current_value) {
+      ++count;
+    } else {
+      current_value = value;
+      count = 1;
+    }
+  }
+}
+
 }  // namespace operations
 
 #endif  // INDEX_BLOCK_BASED_BLOCK_OPERATIONS_HH
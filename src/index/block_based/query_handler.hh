@@ -5,12 +5,14 @@
 #include <library/batched_read.hh>
 #include <library/latch.hh>
 
+#include "block_counts.hh"
 #include "block_operations.hh"
 #include "compute_thread.hh"
 #include "data_processing/serializer/deserializer.hh"
 #include "index/configuration.hh"
 #include "index/constants.hh"
 #include "index/query/query.hh"
+#include "index/query/query_stream.hh"
 #include "index/shared_context.hh"
 #include "remote_pointer.hh"
 
@@ -20,8 +22,8 @@ class BlockBasedQueryHandler {
 public:
   using Configuration = configuration::IndexConfiguration;
   using ComputeThreads = vec<u_ptr<ComputeThread>>;
-  using SharedContext = SharedContext<ComputeThread>;
-  using Queue = concurrent_queue<u32>;
+  using SharedContext = ::SharedContext<ComputeThread>;
+  using Queue = query::QueryStream;
   inline static const str name = "block";
 
 public:
@@ -78,6 +80,7 @@ public:
                                              const str& index_directory) {
     u32 universe_size{};
     u64 catalog_size = 0;
+    vec<std::pair<u64, u32>> heads;  // global position, term
 
     for (u32 memory_node = 0; memory_node < num_servers; ++memory_node) {
       const str binary_file = index_directory + name +
@@ -113,9 +116,13 @@ public:
 
         r_ptr.memory_node = memory_node;
         r_ptr.offset = offset;
+        heads.emplace_back(
+          global_block_position(memory_node, offset, num_servers), term);
       }
     }
 
+    block_counts_ = estimate_block_counts(heads, universe_size);
+
 #ifdef DEV_DEBUG
     u32 idx = 0;
     for (auto& r_ptr : remote_pointers_) {
@@ -128,6 +135,11 @@ public:
 
   ComputeThreads& get_compute_threads() { return compute_threads_; }
 
+  // in blocks
+  u64 get_list_length(u32 term) const {
+    return term < block_counts_.size() ? block_counts_[term] : 0;
+  }
+
   void process_queries(Queue& query_queue,
                        query::Queries& queries,
                        MemoryRegionTokens& remote_access_tokens,
@@ -141,7 +153,7 @@ public:
     u32 q;  // idx to query
 
     // try pop queue
-    while (query_queue.try_dequeue(q)) {
+    while (query_queue.try_dequeue(q, thread_id)) {
       query::Query& query = queries[q];
       if (query.type != QueryType::READ) {
         continue;
@@ -208,6 +220,7 @@ private:
 
   ComputeThreads compute_threads_;
   RemotePointers remote_pointers_;
+  vec<u32> block_counts_;
 
   HugePage<u32> local_buffer_;
   vec<u_ptr<SharedContext>> shared_contexts_;
@@ -7,14 +7,22 @@
 #include <library/utils.hh>
 
 #include "index/constants.hh"
-// #include "index/crc.hh"
+#include "index/crc32c.hh"
 
 namespace inv_index::block_based {
 
+// cache_line_versioning selects the layout of dynamic blocks (whose cache
+// lines are versioned unless they are validated by a CRC32C)
 template <bool cache_line_versioning>
 class ReadBuffer {
 public:
   struct BufferBlock {
+    static constexpr bool line_versions =
+      cache_line_versioning && CACHE_LINE_VERSIONS;
+    static constexpr u32 first_position = line_versions ? 1 : 0;
+    static constexpr u32 footer_length =
+      cache_line_versioning ? DYNAMIC_FOOTER_SIZE / sizeof(u32) : 2;
+
     const u32 block_length;
 
     // store temporary for re-reads: TODO
@@ -52,7 +60,13 @@ public:
     }
 
     u16 get_block_tag() const {
-      return (get_last_word() << (32 + 14)) >> (64 - 16);
+      return (get_last_word() << (32 + 15)) >> (64 - 16);
+    }
+
+    void set_block_tag(u16 tag) {
+      u64& last_word = *get_last_word_ptr();
+      last_word &= ~(static_cast<u64>(static_cast<u16>(-1)) << 1);
+      last_word |= static_cast<u64>(tag) << 1;
     }
 
     u64 get_raw_remote_ptr() const {
@@ -84,41 +98,209 @@ public:
     }
 
     bool is_full() const {
-      return buffer[block_length - 5] != static_cast<u32>(-1);
+      return buffer[get_last_position()] != static_cast<u32>(-1);
+    }
+
+    bool is_empty() const {
+      return buffer[first_position] == static_cast<u32>(-1);
+    }
+
+    static bool is_version_slot(u32 pos) {
+      return line_versions && pos % CACHE_LINE_ITEMS == 0;
+    }
+
+    // position of the e-th entry (skipping the cache line versions)
+    static u32 get_entry_position(u32 e) {
+      if constexpr (!line_versions) {
+        return e;
+      }
+
+      return e / (CACHE_LINE_ITEMS - 1) * CACHE_LINE_ITEMS +
+             e % (CACHE_LINE_ITEMS - 1) + 1;
+    }
+
+    // position of the last entry of a full block
+    u32 get_last_position() const {
+      return get_entry_position(get_capacity() - 1);
+    }
+
+    // cache lines [first, end) holding the entries [first_entry, end_entry)
+    static std::pair<u32, u32> get_entry_lines(u32 first_entry,
+                                               u32 end_entry) {
+      if (first_entry >= end_entry) {
+        return {0, 0};
+      }
+
+      return {get_entry_position(first_entry) / CACHE_LINE_ITEMS,
+              get_entry_position(end_entry - 1) / CACHE_LINE_ITEMS + 1};
     }
 
-    //    u64 get_encoded_crc() const {
-    //      return (static_cast<u64>(buffer[block_length - 3]) << 32) |
-    //             buffer[block_length - 2];
-    //    }
+    // entries are packed, so we search the first invalid position
+    u32 count_entries() const {
+      u32 count = 0;
+      u32 last = get_capacity();
+
+      while (count < last) {
+        const u32 mid = count + (last - count) / 2;
+        if (buffer[get_entry_position(mid)] != static_cast<u32>(-1)) {
+          count = mid + 1;
+        } else {
+          last = mid;
+        }
+      }
+
+      return count;
+    }
+
+    // entries including reserved slots, maintained by appends and WRITEs
+    u32 get_fill_count() const {
+      return (get_last_word() << 32) >> (64 - 15);
+    }
+
+    void set_fill_count(u32 count) {
+      u64& last_word = *get_last_word_ptr();
+      last_word &= ~(static_cast<u64>((1u << 15) - 1) << 17);
+      last_word |= static_cast<u64>(count) << 17;
+    }
+
+    // a slot has been reserved but its entry has not arrived yet
+    bool has_pending_append() const {
+      const u32 count = get_fill_count();
+      return count > 0 && count <= get_capacity() &&
+             buffer[get_entry_position(count - 1)] == static_cast<u32>(-1);
+    }
+
+    // number of entries that fit into a block
+    u32 get_capacity() const {
+      const u32 num_versions = line_versions ? get_num_cache_lines() : 0;
+      return block_length - footer_length - num_versions;
+    }
+
+    void collect_entries(vec<u32>& entries) const {
+      const u32 read_until = block_length - footer_length;
+
+      for (u32 i = first_position; i < read_until; ++i) {
+        if (is_version_slot(i)) {
+          continue;
+        }
+
+        if (buffer[i] == static_cast<u32>(-1)) {
+          break;
+        }
+
+        entries.push_back(buffer[i]);
+      }
+    }
+
+    // stores the (ordered) entries and invalidates the remaining positions
+    void assign_entries(const vec<u32>& entries) {
+      lib_assert(entries.size() <= get_capacity(), "too many entries");
+      const u32 read_until = block_length - footer_length;
+      u32 e = 0;
+
+      for (u32 i = first_position; i < read_until; ++i) {
+        if (!is_version_slot(i)) {
+          buffer[i] = e < entries.size() ? entries[e++] : static_cast<u32>(-1);
+        }
+      }
+    }
+
+    u32 get_num_cache_lines() const {
+      return block_length * sizeof(u32) / CACHE_LINE_SIZE;
+    }
+
+    u32 get_version() const { return get_last_word() >> 32; }
+
+    // the version slot of the last cache line (which shares the version of
+    // the footer) holds the range of cache lines [first, end) of the last
+    // WRITE, all other cache lines have been written before
+    std::pair<u32, u32> get_written_lines() const {
+      const u32 range = buffer[block_length - CACHE_LINE_ITEMS];
+      return {range >> 16, (range << 16) >> 16};
+    }
 
     bool validate_cache_lines() {
-      const u32 num_cache_lines = block_length * sizeof(u32) / CACHE_LINE_SIZE;
-      const u32 version = buffer[0];
+      const u32 num_cache_lines = get_num_cache_lines();
+      const u32 version = get_version();
+      const auto [first, end] = get_written_lines();
 
-      for (u32 j = 1; j < num_cache_lines; ++j) {
-        u32 idx = j * CACHE_LINE_SIZE / sizeof(u32);
+      for (u32 j = 0; j < num_cache_lines - 1; ++j) {
+        const u32 line_version = buffer[j * CACHE_LINE_ITEMS];
+        const bool written = j >= first && j < end;
 
-        if (buffer[idx] != version) {
+        if (written ? line_version != version : line_version > version) {
           is_valid = false;
           return false;
         }
       }
 
+      // an append is in progress
+      if (has_pending_append()) {
+        is_valid = false;
+        return false;
+      }
+
       is_valid = true;
       return true;
     }
 
-    void increase_cache_line_versions() {
-      const u32 num_cache_lines = block_length * sizeof(u32) / CACHE_LINE_SIZE;
-      const u32 version = buffer[0] + 1;
+    // the crc footer: [ crc | covered entries | r_ptr (64) | flags (64) ]
+    u32 get_stored_crc() const { return buffer[block_length - 6]; }
+    u32 get_covered_entries() const { return buffer[block_length - 5]; }
+
+    // checksum of the first covered entries and the remote pointer (entries
+    // appended into reserved slots are not covered until the next WRITE)
+    u32 compute_crc(u32 covered) const {
+      const u32 crc = crc32c(buffer, covered * sizeof(u32));
+      return crc32c(buffer + block_length - 4, sizeof(u64), crc);
+    }
+
+    bool validate_crc() {
+      const u32 covered = get_covered_entries();
+      is_valid = covered <= get_capacity() &&
+                 compute_crc(covered) == get_stored_crc() &&
+                 !has_pending_append() &&
+                 count_entries() <= std::max(covered, get_fill_count());
+      return is_valid;
+    }
 
-      for (u32 j = 0; j < num_cache_lines; ++j) {
-        u32 idx = j * CACHE_LINE_SIZE / sizeof(u32);
-        buffer[idx] = version;
+    bool validate() {
+      if constexpr (line_versions) {
+        return validate_cache_lines();
       }
 
-      // also increase the version of the last word (but interpreted w/ 64bit)
+      return validate_crc();
+    }
+
+    // versions the cache lines [first, end) and the last cache line
+    void increase_cache_line_versions(u32 first, u32 end) {
+      const u32 version = get_version() + 1;
+
+      for (u32 j = first; j < end; ++j) {
+        buffer[j * CACHE_LINE_ITEMS] = version;
+      }
+
+      buffer[block_length - CACHE_LINE_ITEMS] = (first << 16) | end;
+      set_version(version);
+    }
+
+    // prepares the WRITE of the cache lines [first, end) and the last one,
+    // the version of the last word changes with every WRITE
+    void version_block(u32 first, u32 end) {
+      if constexpr (line_versions) {
+        increase_cache_line_versions(first, end);
+        return;
+      }
+
+      // a crc covers the whole block (all other lines must be unchanged)
+      const u32 covered = count_entries();
+      buffer[block_length - 6] = compute_crc(covered);
+      buffer[block_length - 5] = covered;
+      set_version(get_version() + 1);
+    }
+
+    void set_version(u32 version) {
+      // the version of the last word (but interpreted w/ 64bit)
       u64& last_word = *get_last_word_ptr();
 
       last_word = (last_word << 32) >> 32;  // remove old version
@@ -126,13 +308,13 @@ public:
     }
 
     std::tuple<u32, u32, u32> get_min_max() {
-      const u32 min = buffer[1];
+      const u32 min = buffer[first_position];
       lib_assert(min != static_cast<u32>(-1), "invalid state");
 
-      u32 max_pos = block_length - 5;
-      while (max_pos > 1) {
+      u32 max_pos = get_last_position();
+      while (max_pos > first_position) {
         // if we hit a cache line version or value is empty
-        if ((max_pos % (CACHE_LINE_SIZE / sizeof(u32)) == 0) ||
+        if (is_version_slot(max_pos) ||
             (buffer[max_pos] == static_cast<u32>(-1))) {
           max_pos--;
         } else {
@@ -149,15 +331,15 @@ public:
 
     // returns the first free positions of the involved blocks
     std::pair<u32, u32> split_block(BufferBlock& target) {
-      const u32 num_cache_lines = block_length * sizeof(u32) / CACHE_LINE_SIZE;
-      const u32 read_until = block_length - DYNAMIC_FOOTER_SIZE / sizeof(u32);
+      const u32 num_cache_lines = get_num_cache_lines();
+      const u32 read_until = block_length - footer_length;
       const u32 tombstone = static_cast<u32>(-1);
 
-      u32 target_iter = 1;
-      u32 move_from = num_cache_lines / 2 * CACHE_LINE_ITEMS + 1;
+      u32 target_iter = first_position;
+      u32 move_from = num_cache_lines / 2 * CACHE_LINE_ITEMS + first_position;
 
       for (u32 i = move_from; i < read_until; ++i) {
-        if (i % CACHE_LINE_ITEMS == 0) {
+        if (is_version_slot(i)) {
           continue;
         }
 
@@ -165,14 +347,14 @@ public:
         buffer[i] = tombstone;
         ++target_iter;
 
-        if (target_iter % CACHE_LINE_ITEMS == 0) {
+        if (is_version_slot(target_iter)) {
           ++target_iter;
         }
       }
 
       // invalidate remaining entries
       for (u32 j = target_iter; j < read_until; ++j) {
-        if (j % CACHE_LINE_ITEMS != 0) {
+        if (!is_version_slot(j)) {
           target.buffer[j] = tombstone;
         }
       }
@@ -194,12 +376,6 @@ public:
                 << *(reinterpret_cast<u64*>(buffer) + block_length / 2 - 1)
                 << " ]\n}\n";
     }
-
-    //    bool checksum_is_valid() const {
-    //      const u64 computed_crc = crc64(reinterpret_cast<byte*>(buffer),
-    //                                     (block_length - 3) * sizeof(u32));
-    //      return computed_crc == get_encoded_crc();
-    //    }
   };
 
   ReadBuffer(u32 block_size, HugePage<u32>& local_buffer)
@@ -0,0 +1,122 @@
+#ifndef INDEX_BLOCK_BASED_DYNAMIC_BLOCK_CACHE_HH
+#define INDEX_BLOCK_BASED_DYNAMIC_BLOCK_CACHE_HH
+
+#include <algorithm>
+#include <library/types.hh>
+#include <mutex>
+#include <unordered_map>
+
+#include "index/constants.hh"
+
+namespace inv_index::block_based::dynamic {
+
+// validated copies of remote blocks shared by the compute threads of a node,
+// keyed by the remote address of a block; a copy is only used if the footer
+// (version, fill, tag, and lock) READ from the remote block is unchanged
+// (every WRITE increases the version, every reservation the fill, and every
+// re-use the tag), the shards are replaced with the clock algorithm
+class BlockCache {
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<u64, u32> slots;  // remote address -> slot
+    vec<u64> keys;                       // slot -> remote address
+    vec<bool> referenced;
+    u_ptr<u32[]> blocks;
+    u32 hand{0};
+  };
+
+public:
+  BlockCache(u32 num_blocks, u32 block_size)
+      : block_length_(block_size / sizeof(u32)),
+        shard_blocks_(std::max<u32>(num_blocks / BLOCK_CACHE_SHARDS, 1)),
+        shards_(BLOCK_CACHE_SHARDS) {
+    for (Shard& shard : shards_) {
+      shard.slots.reserve(shard_blocks_);
+      shard.referenced.resize(shard_blocks_);
+      shard.blocks = std::make_unique<u32[]>(
+        static_cast<u64>(shard_blocks_) * block_length_);
+    }
+  }
+
+  // copies the cached block into the buffer, returns false if not cached
+  bool lookup(u32 node, u32 offset, u32* buffer) {
+    const u64 key = get_key(node, offset);
+    Shard& shard = get_shard(key);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+
+    const auto it = shard.slots.find(key);
+    if (it == shard.slots.end()) {
+      return false;
+    }
+
+    shard.referenced[it->second] = true;
+    std::copy_n(get_block(shard, it->second), block_length_, buffer);
+    return true;
+  }
+
+  // stores a validated block (replaces an older copy of the block)
+  void insert(u32 node, u32 offset, const u32* buffer) {
+    const u64 key = get_key(node, offset);
+    Shard& shard = get_shard(key);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+
+    u32 slot;
+    const auto it = shard.slots.find(key);
+    if (it != shard.slots.end()) {
+      slot = it->second;
+    } else {
+      slot = evict(shard);
+      shard.slots.emplace(key, slot);
+      shard.keys[slot] = key;
+    }
+
+    shard.referenced[slot] = true;
+    std::copy_n(buffer, block_length_, get_block(shard, slot));
+  }
+
+  u64 get_size_in_bytes() const {
+    return static_cast<u64>(shards_.size()) * shard_blocks_ * block_length_ *
+           sizeof(u32);
+  }
+
+private:
+  static u64 get_key(u32 node, u32 offset) {
+    return (static_cast<u64>(node) << 32) | offset;
+  }
+
+  Shard& get_shard(u64 key) {
+    return shards_[std::hash<u64>{}(key) % shards_.size()];
+  }
+
+  u32* get_block(Shard& shard, u32 slot) const {
+    return shard.blocks.get() + static_cast<u64>(slot) * block_length_;
+  }
+
+  // returns a free slot (the first slot without a reference bit)
+  u32 evict(Shard& shard) {
+    if (shard.keys.size() < shard_blocks_) {
+      shard.keys.push_back(0);
+      return shard.keys.size() - 1;
+    }
+
+    while (shard.referenced[shard.hand]) {
+      shard.referenced[shard.hand] = false;
+      shard.hand = (shard.hand + 1) % shard_blocks_;
+    }
+
+    const u32 slot = shard.hand;
+    shard.hand = (shard.hand + 1) % shard_blocks_;
+    shard.slots.erase(shard.keys[slot]);
+
+    return slot;
+  }
+
+private:
+  const u32 block_length_;
+  const u32 shard_blocks_;
+  vec<Shard> shards_;
+};
+
+}  // namespace inv_index::block_based::dynamic
+
+#endif  // INDEX_BLOCK_BASED_DYNAMIC_BLOCK_CACHE_HH
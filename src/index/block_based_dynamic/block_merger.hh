@@ -0,0 +1,150 @@
+#ifndef INDEX_BLOCK_BASED_DYNAMIC_BLOCK_MERGER_HH
+#define INDEX_BLOCK_BASED_DYNAMIC_BLOCK_MERGER_HH
+
+#include <library/types.hh>
+
+#include "block_pool.hh"
+#include "compute_thread.hh"
+#include "remote_pointer.hh"
+
+namespace inv_index::block_based::dynamic {
+
+// splits leave blocks half-full, the merger scans the lists and lets a block
+// absorb its successor if the entries of both fill at most merge_fill percent
+// of a block (s.t. the merged block does not split right away)
+class BlockMerger {
+  using BufferBlock = ReadBuffer<true>::BufferBlock;
+
+public:
+  // entries and blocks seen by a pass (after its merges)
+  struct Fill {
+    u64 entries{0};
+    u64 blocks{0};
+
+    f64 get_factor(u32 capacity) const {
+      return blocks == 0 ? 0.0
+                         : static_cast<f64>(entries) / (blocks * capacity);
+    }
+  };
+
+  BlockMerger(u32 merge_fill, u32 capacity)
+      : max_entries_(capacity * merge_fill / 100), capacity_(capacity) {}
+
+  // a pass over the given lists
+  template <typename F>
+  void merge_lists(const vec<u32>& terms,
+                   const RemotePointers& remote_pointers,
+                   BlockPools& block_pools,
+                   u_ptr<ComputeThread>& thread,
+                   F deallocate_block) {
+    Fill fill;
+    u64 merged = 0;
+
+    for (u32 term : terms) {
+      merged += merge_list(
+        remote_pointers[term], block_pools, thread, deallocate_block, fill);
+    }
+
+    // merges do not change the number of entries
+    if (num_passes_++ == 0) {
+      first_pass_ = {fill.entries, fill.blocks + merged};
+    }
+    last_pass_ = fill;
+  }
+
+  f64 get_fill_before() const { return first_pass_.get_factor(capacity_); }
+  f64 get_fill_after() const { return last_pass_.get_factor(capacity_); }
+  u64 get_num_passes() const { return num_passes_; }
+
+private:
+  // the current block is kept in row, its successor is READ into the next
+  // row, lists that change meanwhile are merged by the next pass, returns the
+  // number of merges
+  template <typename F>
+  u64 merge_list(RemotePtr r,
+                 BlockPools& block_pools,
+                 u_ptr<ComputeThread>& thread,
+                 F deallocate_block,
+                 Fill& fill) {
+    u64 merged = 0;
+    u32 row = 0;
+    u16 tag = r.tag;  // of the head block
+
+    r.READ_block(0, row, block_pools, thread);
+    wait(thread);
+
+    while (true) {
+      auto& block = thread->read_buffer.get_block(0, row);
+      if (block.get_block_tag() != tag) {
+        thread->list_repeated_reads++;
+        return merged;
+      }
+
+      const u32 num_entries = block.count_entries();
+      if (block.points_to_null()) {
+        fill.entries += num_entries;
+        fill.blocks++;
+        return merged;
+      }
+
+      const u32 next_row = (row + 1) % READ_BUFFER_DEPTH;
+      const u16 next_tag = block.get_remote_ptr_tag();
+      auto [next_node, next_offs] = block.get_remote_ptr();
+      RemotePtr next{next_node, next_offs};
+
+      next.READ_block(0, next_row, block_pools, thread);
+      wait(thread);
+
+      auto& successor = thread->read_buffer.get_block(0, next_row);
+      if (successor.get_block_tag() != next_tag) {
+        thread->list_repeated_reads++;
+        return merged;
+      }
+
+      // the block absorbs its successor and is READ again (it may absorb
+      // the next successor as well)
+      if (num_entries + successor.count_entries() <= max_entries_ &&
+          RemotePtr::merge_with_successor(0,
+                                          row,
+                                          r,
+                                          max_entries_,
+                                          block_pools,
+                                          thread,
+                                          deallocate_block)) {
+        thread->merged_blocks++;
+        merged++;
+
+        // the WRITE must complete before the buffer is READ into again
+        wait(thread);
+        r.READ_block(0, row, block_pools, thread);
+        wait(thread);
+        continue;
+      }
+
+      fill.entries += num_entries;
+      fill.blocks++;
+
+      row = next_row;
+      tag = next_tag;
+      r = next;
+    }
+  }
+
+  static void wait(u_ptr<ComputeThread>& thread) {
+    while (thread->post_balance > 0) {
+      thread->poll_cq_and_handle();
+    }
+  }
+
+private:
+  const u32 max_entries_;
+  const u32 capacity_;
+
+  u64 num_passes_{0};
+  Fill first_pass_;
+  Fill last_pass_;
+};
+
+}  // namespace inv_index::block_based::dynamic
+
+#endif  // INDEX_BLOCK_BASED_DYNAMIC_BLOCK_MERGER_HH
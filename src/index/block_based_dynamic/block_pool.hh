@@ -0,0 +1,211 @@
+#ifndef INDEX_BLOCK_BASED_DYNAMIC_BLOCK_POOL_HH
+#define INDEX_BLOCK_BASED_DYNAMIC_BLOCK_POOL_HH
+
+#include <array>
+#include <atomic>
+#include <library/types.hh>
+#include <mutex>
+
+#include "compute_thread.hh"
+#include "free_list.hh"
+#include "segment_table.hh"
+
+namespace inv_index::block_based::dynamic {
+
+// blocks of a memory node, the pool consists of segments (each with its own
+// memory region and free list) and grows on request of a compute thread
+class BlockPool {
+public:
+  BlockPool(u32 block_size,
+            u32 memory_node,
+            u32 free_list_offset,
+            MRT& index_token,
+            MRT& table_token)
+      : block_size_(block_size),
+        memory_node_(memory_node),
+        table_token_(table_token) {
+    // the initial segment is the index buffer
+    add_segment(0, {0, free_list_offset, *index_token});
+    num_segments_ = 1;
+  }
+
+  // returns the (raw) remote offset to the allocated buffer
+  u64 allocate(u_ptr<ComputeThread>& thread) {
+    thread->remote_allocations++;
+    auto& cached_blocks =
+      thread->free_list_buffers[memory_node_]->cached_blocks;
+    bool rescanned = false;
+
+    while (cached_blocks.empty()) {
+      const u32 known_segments = num_segments_.load();
+
+      // prefer the most recent segment, older ones are likely exhausted
+      for (u32 s = known_segments; s-- > 0 && cached_blocks.empty();) {
+        if (!exhausted_[s] && !free_lists_[s]->claim_run(thread)) {
+          exhausted_[s] = true;
+        }
+      }
+
+      if (cached_blocks.empty() && !grow(known_segments, thread)) {
+        // other compute nodes might have returned blocks in the meantime
+        lib_assert(!rescanned, "memory node out of memory");
+        rescanned = true;
+
+        for (u32 s = 0; s < known_segments; ++s) {
+          exhausted_[s] = false;
+        }
+      }
+    }
+
+    const u32 block = cached_blocks.back();
+    cached_blocks.pop_back();
+
+    return static_cast<u64>(block) * block_size_;
+  }
+
+  void deallocate(u64 raw_offset, u_ptr<ComputeThread>& thread) {
+    thread->remote_deallocations++;
+    push_block(raw_offset / block_size_, thread);
+  }
+
+  // returns the claimed but unused blocks of the thread
+  void release_cached_blocks(u_ptr<ComputeThread>& thread) {
+    auto& cached_blocks =
+      thread->free_list_buffers[memory_node_]->cached_blocks;
+
+    for (u32 block : cached_blocks) {
+      push_block(block, thread);
+    }
+
+    cached_blocks.clear();
+  }
+
+  // token of the segment containing the block
+  MRT& get_token(u32 block, u_ptr<ComputeThread>& thread) {
+    u32 known_segments = num_segments_.load(std::memory_order_acquire);
+
+    if (block >= end_blocks_[known_segments - 1]) {
+      // the block has been allocated from a segment we have not seen yet
+      std::lock_guard<std::mutex> guard(mutex_);
+      refresh_segments(thread);
+
+      known_segments = num_segments_.load(std::memory_order_acquire);
+      lib_assert(block < end_blocks_[known_segments - 1], "unknown block");
+    }
+
+    return tokens_[find_segment(block, known_segments)];
+  }
+
+  u32 get_num_segments() const { return num_segments_; }
+
+private:
+  u32 find_segment(u32 block, u32 known_segments) const {
+    u32 s = known_segments - 1;
+    while (block < first_blocks_[s]) {
+      --s;
+    }
+
+    return s;
+  }
+
+  void push_block(u32 block, u_ptr<ComputeThread>& thread) {
+    const u32 s = find_segment(block, num_segments_.load());
+    free_lists_[s]->push_block(block, thread);
+    exhausted_[s] = false;
+  }
+
+  void add_segment(u32 s, const Segment& segment) {
+    tokens_[s] = std::make_unique<MemoryRegionToken>(segment.token);
+    first_blocks_[s] = segment.first_block;
+    end_blocks_[s] = segment.get_free_list_offset();
+    free_lists_[s] = std::make_unique<freelist::FreeList>(block_size_,
+                                                          memory_node_,
+                                                          first_blocks_[s],
+                                                          end_blocks_[s],
+                                                          tokens_[s]);
+    exhausted_[s] = false;
+  }
+
+  // READs the segment table of the memory node (must hold the mutex)
+  void refresh_segments(u_ptr<ComputeThread>& thread) {
+    auto& flb = thread->free_list_buffers[memory_node_];
+    QP& qp = thread->qps[memory_node_]->qp;
+
+    thread->post_balance++;
+    qp->post_send_with_id(flb->table_region,
+                          sizeof(SegmentTable),
+                          IBV_WR_RDMA_READ,
+                          WR_READ_NO_HANDLE,
+                          true,
+                          table_token_.get());
+
+    while (thread->post_balance > 0) {
+      thread->poll_cq_and_handle();
+    }
+
+    const u32 known_segments = num_segments_.load();
+    const u32 num_segments = flb->table.num_segments;
+    for (u32 s = known_segments; s < num_segments; ++s) {
+      add_segment(s, flb->table.segments[s]);
+    }
+
+    if (num_segments > known_segments) {
+      num_segments_.store(num_segments, std::memory_order_release);
+    }
+  }
+
+  // asks the memory node for a new segment, returns false if it cannot grow
+  bool grow(u32 known_segments, u_ptr<ComputeThread>& thread) {
+    std::lock_guard<std::mutex> guard(mutex_);
+
+    // another thread or compute node might have grown the pool already
+    refresh_segments(thread);
+    if (num_segments_ > known_segments) {
+      return true;
+    }
+
+    auto& flb = thread->free_list_buffers[memory_node_];
+    QP& qp = thread->qps[memory_node_]->qp;
+    ControlMessage message{ControlType::GROW, known_segments};
+
+    qp->post_receive(flb->reply_region);
+    thread->post_balance++;
+    qp->post_send_inlined(
+      std::addressof(message), sizeof(ControlMessage), IBV_WR_SEND);
+
+    while (thread->post_balance > 0) {
+      thread->poll_cq_and_handle();
+    }
+
+    thread->local_context.receive();
+    if (flb->reply == known_segments) {
+      return false;
+    }
+
+    thread->pool_growths++;
+    refresh_segments(thread);
+
+    return num_segments_ > known_segments;
+  }
+
+private:
+  const u32 block_size_;
+  const u32 memory_node_;
+  MRT& table_token_;
+
+  // segments are only appended, the first num_segments_ entries are valid
+  std::atomic<u32> num_segments_{0};
+  std::array<MRT, MAX_SEGMENTS> tokens_;
+  std::array<u64, MAX_SEGMENTS> first_blocks_{};
+  std::array<u64, MAX_SEGMENTS> end_blocks_{};
+  std::array<u_ptr<freelist::FreeList>, MAX_SEGMENTS> free_lists_;
+  std::array<std::atomic<bool>, MAX_SEGMENTS> exhausted_{};
+
+  std::mutex mutex_;  // serializes refreshing and growing
+};
+
+using BlockPools = vec<u_ptr<BlockPool>>;  // per memory node
+
+}  // namespace inv_index::block_based::dynamic
+
+#endif  // INDEX_BLOCK_BASED_DYNAMIC_BLOCK_POOL_HH
@@ -0,0 +1,336 @@
+#ifndef INDEX_BLOCK_BASED_DYNAMIC_BULK_INGEST_HH
+#define INDEX_BLOCK_BASED_DYNAMIC_BULK_INGEST_HH
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <library/types.hh>
+#include <library/utils.hh>
+
+#include "block_pool.hh"
+#include "compute_thread.hh"
+#include "index/constants.hh"
+#include "remote_pointer.hh"
+
+namespace inv_index::block_based::dynamic {
+
+// inverts a documents file (lines "<doc-id>: <term_1> ... <term_n>") into
+// ordered and unique lists
+inline vec<vec<u32>> invert_documents(const str& filename, u32 universe_size) {
+  print_status("invert documents");
+  vec<vec<u32>> lists(universe_size + 1);
+
+  std::ifstream input_s(filename, std::ios_base::in);
+  lib_assert(input_s.is_open(), "Cannot open '" + filename + "'");
+
+  str line;
+  while (std::getline(input_s, line)) {
+    char* token = std::strtok(const_cast<char*>(line.c_str()), ":");
+    if (token == nullptr) {
+      continue;
+    }
+
+    const u32 doc_id = std::stoi(token);
+
+    token = std::strtok(nullptr, " ");
+    while (token != nullptr) {
+      const u32 term = std::stoi(token);
+      lib_assert(term <= universe_size, "invalid term in documents");
+
+      lists[term].push_back(doc_id);
+      token = std::strtok(nullptr, " ");
+    }
+  }
+
+  for (auto& list : lists) {
+    std::sort(list.begin(), list.end());
+    list.erase(std::unique(list.begin(), list.end()), list.end());
+  }
+
+  return lists;
+}
+
+// ingests ordered lists of ids at once: ids up to the maximum of the tail
+// block are merged into the existing blocks (with a single lock/WRITE cycle
+// per block), the remaining ids are packed into full blocks that are written
+// in windows and spliced onto the tail with a single locked footer update
+template <typename FAllocate, typename FDeallocate>
+class BulkIngest {
+  using BufferBlock = ReadBuffer<true>::BufferBlock;
+
+  // the last READ block of a list
+  struct Tail {
+    u32 row;
+    u32 node;
+    u32 offs;
+  };
+
+public:
+  BulkIngest(RemotePointers& remote_pointers,
+             TailHints& tail_hints,
+             BlockPools& block_pools,
+             u_ptr<ComputeThread>& thread,
+             FAllocate allocate_block,
+             FDeallocate deallocate_block)
+      : remote_pointers_(remote_pointers),
+        tail_hints_(tail_hints),
+        block_pools_(block_pools),
+        thread_(thread),
+        allocate_block_(allocate_block),
+        deallocate_block_(deallocate_block),
+        window_(std::min<u32>(INGEST_WINDOW, thread->get_max_send_queue_wr())),
+        block_length_(RemotePtr::block_size / sizeof(u32)),
+        staging_(std::make_unique<u32[]>(window_ * block_length_)),
+        staging_region_(thread->local_context,
+                        staging_.get(),
+                        window_ * RemotePtr::block_size),
+        footers_(window_),
+        footer_region_(thread->local_context,
+                       footers_.data(),
+                       window_ * sizeof(u64)) {}
+
+  void ingest(u32 term, vec<u32> ids) {
+    RemotePtr& head = remote_pointers_[term];
+    std::atomic<u64>& tail_hint = tail_hints_[term];
+    const u64 num_ids = ids.size();
+
+    // encoded remote pointers to the written (but unreachable) blocks
+    vec<u64> chain;
+
+    while (!ids.empty()) {
+      const Tail tail = find_tail(term);
+      auto& block = thread_->read_buffer.get_block(0, tail.row);
+
+      auto split = ids.begin();
+      if (!block.is_empty()) {
+        split = std::upper_bound(
+          ids.begin(), ids.end(), std::get<1>(block.get_min_max()));
+      }
+
+      // merge ids belonging to existing blocks, the tail may change
+      if (split != ids.begin()) {
+        release_chain(chain);
+
+        vec<u32> merged(ids.begin(), split);
+        while (!head.find_blocks_and_insert(
+          merged, 0, block_pools_, thread_, allocate_block_, tail_hint)) {
+        }
+
+        ids.erase(ids.begin(), split);
+        continue;
+      }
+
+      if (chain.empty()) {
+        chain = write_chain(ids);
+      }
+
+      if (splice(tail, chain.front())) {
+        tail_hint = chain.back();
+        thread_->ingested_blocks += chain.size();
+        ids.clear();
+      }
+    }
+
+    thread_->ingested_postings += num_ids;
+  }
+
+private:
+  // READs the list up to its tail block (starting at the hinted tail)
+  Tail find_tail(u32 term) {
+    const RemotePtr& head = remote_pointers_[term];
+    std::atomic<u64>& tail_hint = tail_hints_[term];
+
+    while (true) {
+      u16 expected_tag = head.tag;
+      u32 node = head.memory_node;
+      u32 offs = head.offset;
+
+      const u64 hint = tail_hint;
+      const bool from_tail = hint != RemotePtr::NO_TAIL_HINT;
+      if (from_tail) {
+        std::tie(expected_tag, node, offs) = RemotePtr::decode_remote_ptr(hint);
+      }
+
+      for (u32 row = 0;; row = (row + 1) % READ_BUFFER_DEPTH) {
+        RemotePtr p{node, offs};
+        p.READ_block(0, row, block_pools_, thread_);
+
+        while (thread_->post_balance > 0) {
+          thread_->poll_cq_and_handle();
+        }
+
+        auto& block = thread_->read_buffer.get_block(0, row);
+
+        // block has been re-used meanwhile, re-start READing the list
+        if (block.get_block_tag() != expected_tag) {
+          if (from_tail) {
+            RemotePtr::drop_tail_hint(tail_hint, hint, thread_);
+          } else {
+            thread_->list_repeated_reads++;
+          }
+
+          break;
+        }
+
+        if (block.points_to_null()) {
+          if (from_tail) {
+            thread_->tail_hint_hits++;
+          }
+
+          return {row, node, offs};
+        }
+
+        expected_tag = block.get_remote_ptr_tag();
+        std::tie(node, offs) = block.get_remote_ptr();
+      }
+    }
+  }
+
+  // writes the ids into newly allocated (full) blocks, returns the encoded
+  // remote pointers to the blocks in list order
+  vec<u64> write_chain(const vec<u32>& ids) {
+    const u32 capacity = BufferBlock{staging_.get(), RemotePtr::block_size}
+                           .get_capacity();
+    const u32 num_blocks = (ids.size() + capacity - 1) / capacity;
+
+    vec<RemotePtr> blocks;
+    blocks.reserve(num_blocks);
+    for (u32 b = 0; b < num_blocks; ++b) {
+      blocks.push_back(allocate_block_());
+    }
+
+    // READ the footers of the blocks (we must keep the block tags to detect
+    // ABA issues)
+    vec<u64> footers(num_blocks);
+    for (u32 first = 0; first < num_blocks; first += window_) {
+      const u32 end = std::min(first + window_, num_blocks);
+
+      for (u32 b = first; b < end; ++b) {
+        const RemotePtr& r = blocks[b];
+        thread_->post_balance++;
+        thread_->rdma_reads_in_bytes += sizeof(u64);
+
+        thread_->qps[r.memory_node]->qp->post_send(
+          footer_region_.get_address(),
+          sizeof(u64),
+          footer_region_.get_lkey(),
+          IBV_WR_RDMA_READ,
+          true,
+          false,
+          r.get_token(block_pools_, thread_).get(),
+          static_cast<u64>(r.offset + 1) * RemotePtr::block_size -
+            sizeof(u64),
+          (b - first) * sizeof(u64),
+          WR_READ_NO_HANDLE);
+      }
+
+      while (thread_->post_balance > 0) {
+        thread_->poll_cq_and_handle();
+      }
+
+      std::copy_n(footers_.begin(), end - first, footers.begin() + first);
+    }
+
+    vec<u64> chain(num_blocks);
+    for (u32 b = 0; b < num_blocks; ++b) {
+      BufferBlock block{staging_.get(), RemotePtr::block_size};
+      *block.get_last_word_ptr() = footers[b];
+
+      chain[b] = RemotePtr::encode_remote_ptr(
+        block.get_block_tag(), blocks[b].memory_node, blocks[b].offset);
+    }
+
+    // WRITE the blocks, none of them is reachable before the splice
+    vec<u32> entries;
+    for (u32 first = 0; first < num_blocks; first += window_) {
+      const u32 end = std::min(first + window_, num_blocks);
+
+      for (u32 b = first; b < end; ++b) {
+        const RemotePtr& r = blocks[b];
+        BufferBlock block{staging_.get() + (b - first) * block_length_,
+                          RemotePtr::block_size};
+
+        entries.assign(
+          ids.begin() + b * capacity,
+          ids.begin() + std::min<u64>((b + 1) * capacity, ids.size()));
+
+        *block.get_last_word_ptr() = footers[b];
+        block.set_unlock();
+        block.assign_entries(entries);
+        block.set_raw_remote_ptr(b + 1 < num_blocks ? chain[b + 1] : 0);
+
+        RemotePtr::WRITE_block(block,
+                               WR_WRITE_INGEST,
+                               staging_region_.get_lkey(),
+                               thread_->qps[r.memory_node]->qp,
+                               r.offset,
+                               r.get_token(block_pools_, thread_),
+                               thread_);
+      }
+
+      while (thread_->post_balance > 0) {
+        thread_->poll_cq_and_handle();
+      }
+    }
+
+    return chain;
+  }
+
+  // links the chain to the tail block (unless it has changed meanwhile)
+  bool splice(const Tail& tail, u64 first) {
+    auto& block = thread_->read_buffer.get_block(0, tail.row);
+    QP& qp = thread_->qps[tail.node]->qp;
+    MRT& mrt = block_pools_[tail.node]->get_token(tail.offs, thread_);
+
+    if (!RemotePtr::LOCK_block(block, qp, mrt, tail.offs, thread_)) {
+      thread_->locking_failed++;
+      return false;
+    }
+
+    // only the cache line holding the footer changes
+    const u32 last_line = block.get_num_cache_lines() - 1;
+    block.set_raw_remote_ptr(first);
+    const bool spliced = RemotePtr::WRITE_and_unlock_block(
+      0, tail.row, qp, tail.offs, mrt, thread_, last_line, last_line);
+
+    while (thread_->post_balance > 0) {
+      thread_->poll_cq_and_handle();
+    }
+
+    if (spliced) {
+      thread_->insert_commits++;
+    }
+
+    return spliced;
+  }
+
+  // returns blocks of a chain that has never been reachable
+  void release_chain(vec<u64>& chain) {
+    for (u64 encoded : chain) {
+      auto [tag, node, offs] = RemotePtr::decode_remote_ptr(encoded);
+      deallocate_block_(RemotePtr{node, offs});
+    }
+
+    chain.clear();
+  }
+
+private:
+  RemotePointers& remote_pointers_;
+  TailHints& tail_hints_;
+  BlockPools& block_pools_;
+  u_ptr<ComputeThread>& thread_;
+  FAllocate allocate_block_;
+  FDeallocate deallocate_block_;
+
+  const u32 window_;  // blocks READ and WRITten at once
+  const u32 block_length_;
+
+  u_ptr<u32[]> staging_;
+  LocalMemoryRegion staging_region_;
+  vec<u64> footers_;
+  LocalMemoryRegion footer_region_;
+};
+
+}  // namespace inv_index::block_based::dynamic
+
+#endif  // INDEX_BLOCK_BASED_DYNAMIC_BULK_INGEST_HH
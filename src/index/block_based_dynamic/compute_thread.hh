@@ -1,11 +1,16 @@
 #ifndef INDEX_BLOCK_BASED_DYNAMIC_COMPUTE_THREAD_HH
 #define INDEX_BLOCK_BASED_DYNAMIC_COMPUTE_THREAD_HH
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <library/connection_manager.hh>
 #include <library/detached_qp.hh>
 #include <library/thread.hh>
 #include <random>
 
+#include "block_cache.hh"
+#include "contention.hh"
 #include "free_list_buffers.hh"
 #include "index/block_based/read_buffer.hh"
 #include "timing/timing.hh"
@@ -13,6 +18,22 @@
 namespace inv_index::block_based::dynamic {
 constexpr static u64 WR_READ_NO_HANDLE = static_cast<u64>(-1);
 constexpr static u64 WR_WRITE_ALLOCATION_BLOCK = static_cast<u64>(-1);
+constexpr static u64 WR_WRITE_DELTA = static_cast<u64>(-2);
+constexpr static u64 WR_WRITE_INGEST = static_cast<u64>(-3);
+
+// CASs of insert pipeline slots carry the slot: [ 1 | unused (31) | slot (32) ]
+constexpr static u64 WR_CAS_SLOT = static_cast<u64>(1) << 63;
+
+// READs of query blocks carry flags:
+// [ 0 | footer | cache | query | col (28) | row ]
+constexpr static u64 WR_READ_FOOTER = static_cast<u64>(1) << 62;
+constexpr static u64 WR_READ_CACHE = static_cast<u64>(1) << 61;
+constexpr static u64 WR_READ_QUERY = static_cast<u64>(1) << 60;
+constexpr static u64 WR_READ_FLAGS =
+  WR_READ_FOOTER | WR_READ_CACHE | WR_READ_QUERY;
+
+// epoch of threads that do not hold pointers to blocks
+constexpr static u64 QUIESCENT = static_cast<u64>(-1);
 
 class ComputeThread : public Thread {
 public:
@@ -29,6 +50,12 @@ public:
                       local_buffer.get_full_buffer(),
                       local_buffer.buffer_size),
         cas_region(local_context, &cas_buffer, sizeof(u64)),
+        slot_cas_region(local_context,
+                        slot_cas_buffers.data(),
+                        sizeof(slot_cas_buffers)),
+        footer_region(local_context,
+                      footer_buffers.data(),
+                      sizeof(footer_buffers)),
         allocation_buffer(std::make_unique<u32[]>(block_size / sizeof(u32))),
         allocation_block(allocation_buffer.get(), block_size),
         allocation_region(local_context, allocation_buffer.get(), block_size),
@@ -59,12 +86,55 @@ public:
     dist_ = std::uniform_int_distribution<u32>(0, qps.size() - 1);
   }
 
+  using BufferBlock = ReadBuffer<true>::BufferBlock;
+
+  // checks a READ block for torn writes (cache line versions or crc), each
+  // block is validated once right after its READ, i.e., mostly from cold
+  // cache lines
+  bool validate(BufferBlock& block) {
+    ++validated_blocks;
+    if (!time_validation) {
+      return block.validate();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const bool valid = block.validate();
+    validation_time_ns +=
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start)
+        .count();
+    ++timed_validations;
+    return valid;
+  }
+
+  // a block READ by a query has been freed (and possibly reused) since the
+  // pointer to it has been READ: the list ends here and the query is
+  // restarted (the tag is part of the atomic last word, even if the block is
+  // locked or torn)
+  bool drop_stale_block(u64 wr_id, BufferBlock& block, u32 col, u32 row) {
+    if (!(wr_id & WR_READ_QUERY) ||
+        block.get_block_tag() == expected_tags[get_block_index(col, row)]) {
+      return false;
+    }
+
+    ++stale_blocks;
+    stale_query = true;
+    block.assign_entries({});
+    block.set_raw_remote_ptr(0);
+    read_buffer.set_block_ready(col, row);
+    return true;
+  }
+
   void set_ready_and_validate(u64 wr_id) {
-    auto [col, row] = decode_64bit(wr_id);
+    auto [col, row] = decode_64bit(wr_id & ~WR_READ_FLAGS);
     auto& block = read_buffer.get_block(col, row);
 
+    if (drop_stale_block(wr_id, block, col, row)) {
+      return;
+    }
+
     // READ the block again in case the arrived block is locked
-    if (block.is_locked() || !block.validate_cache_lines()) {
+    if (block.is_locked() || !validate(block)) {
       ++block_repeated_reads;
       ++post_balance;
 
@@ -84,8 +154,51 @@ public:
         wr_id);
 
     } else {
+      if (wr_id & WR_READ_CACHE) {
+        block_cache->insert(
+          block.memory_node, block.remote_offset, block.buffer);
+      }
+
+      read_buffer.set_block_ready(col, row);
+    }
+  }
+
+  // the block holds the cached copy, it is used if the READ footer is equal
+  // to the cached one, otherwise the whole block is READ (and cached again)
+  void validate_footer(u64 wr_id) {
+    auto [col, row] = decode_64bit(wr_id & ~WR_READ_FLAGS);
+    auto& block = read_buffer.get_block(col, row);
+
+    if (footer_buffers[get_block_index(col, row)] == block.get_last_word() &&
+        !block.is_locked() && validate(block)) {
+      if (drop_stale_block(wr_id, block, col, row)) {
+        return;
+      }
+
+      ++cache_hits;
       read_buffer.set_block_ready(col, row);
+      return;
     }
+
+    ++cache_stale;
+    ++post_balance;
+    rdma_reads_in_bytes += read_buffer.block_size;
+
+    qps[block.memory_node]->qp->post_send(
+      block.get_address(),
+      read_buffer.block_size,
+      buffer_region.get_lkey(),
+      IBV_WR_RDMA_READ,
+      true,
+      false,
+      block.mrt->get(),
+      block.remote_offset * static_cast<u64>(read_buffer.block_size),
+      0,
+      (wr_id & ~WR_READ_FOOTER) | WR_READ_CACHE);
+  }
+
+  static u32 get_block_index(u32 col, u32 row) {
+    return col * READ_BUFFER_DEPTH + row;
   }
 
   void poll_cq_and_handle() {
@@ -100,21 +213,44 @@ public:
         switch (send_wcs[i].opcode) {
         case IBV_WC_RDMA_READ: {
           const u64 wr_id = send_wcs[i].wr_id;
-          if (wr_id != WR_READ_NO_HANDLE) {
-            // call READ handler
+          if (wr_id == WR_READ_NO_HANDLE) {
+            break;
+          }
+
+          // call READ handler
+          if (wr_id & WR_READ_FOOTER) {
+            validate_footer(wr_id);
+          } else {
             set_ready_and_validate(wr_id);
           }
           break;
         }
-        case IBV_WC_COMP_SWAP:
-          // call CAS handler
+        case IBV_WC_SEND:
+          // control message to a memory node
+          break;
+        case IBV_WC_FETCH_ADD:
+          // synchronous like CAS
           --post_balance_CAS;
           break;
+        case IBV_WC_COMP_SWAP: {
+          const u64 wr_id = send_wcs[i].wr_id;
+
+          if (wr_id & WR_CAS_SLOT) {
+            // asynchronous CAS of an insert pipeline slot
+            slot_cas_pending[decode_64bit(wr_id).second] = false;
+          } else {
+            // call CAS handler
+            --post_balance_CAS;
+          }
+          break;
+        }
         case IBV_WC_RDMA_WRITE: {
           const u64 wr_id = send_wcs[i].wr_id;
 
           if (wr_id == WR_WRITE_ALLOCATION_BLOCK) {
             allocation_block.just_writing = false;
+          } else if (wr_id == WR_WRITE_DELTA || wr_id == WR_WRITE_INGEST) {
+            // nobody waits for delta appends, bulk ingests wait for all WRITEs
           } else {
             auto [col, row] = decode_64bit(wr_id);
             read_buffer.get_block(col, row).just_writing = false;
@@ -138,7 +274,22 @@ public:
       send_wcs.data(), max_send_queue_wr_, local_context.get_send_cq());
   }
 
+  // local copies of delta logs (one per read buffer column)
+  void allocate_delta_buffer(u32 log_entries) {
+    delta_log_entries = log_entries;
+    delta_buffer = std::make_unique<u32[]>(READ_BUFFER_LENGTH * log_entries);
+    delta_region = std::make_unique<LocalMemoryRegion>(
+      local_context,
+      delta_buffer.get(),
+      READ_BUFFER_LENGTH * log_entries * sizeof(u32));
+  }
+
+  u32* get_delta_log(u32 col) const {
+    return delta_buffer.get() + col * delta_log_entries;
+  }
+
   u32 get_random_memory_node() { return dist_(generator_); }
+  i32 get_max_send_queue_wr() const { return max_send_queue_wr_; }
 
 public:
   vec<ibv_wc> send_wcs;
@@ -152,17 +303,80 @@ public:
   u64 cas_buffer{};
   LocalMemoryRegion cas_region;
 
+  // one CAS buffer per insert pipeline slot (slot = read buffer column)
+  std::array<u64, READ_BUFFER_LENGTH> slot_cas_buffers{};
+  std::array<bool, READ_BUFFER_LENGTH> slot_cas_pending{};
+  LocalMemoryRegion slot_cas_region;
+
+  // footers READ to validate cached blocks (one per read buffer block)
+  std::array<u64, READ_BUFFER_LENGTH * READ_BUFFER_DEPTH> footer_buffers{};
+  LocalMemoryRegion footer_region;
+  BlockCache* block_cache{nullptr};  // shared by the threads of a node
+
+  // tags of the blocks READ by queries (one per read buffer block)
+  std::array<u16, READ_BUFFER_LENGTH * READ_BUFFER_DEPTH> expected_tags{};
+  bool stale_query{false};  // a block of the query has been freed meanwhile
+
+  // epoch of the running query (see EpochReclamation) and the freed blocks
+  // that queries might still READ: (epoch, encoded remote pointer)
+  std::atomic<u64> query_epoch{QUIESCENT};
+  vec<std::pair<u64, u64>> retired_blocks;
+
+  u32 delta_log_entries{0};  // both logs of a term
+  u_ptr<u32[]> delta_buffer;
+  u_ptr<LocalMemoryRegion> delta_region;
+
   u_ptr<u32[]> allocation_buffer;
   ReadBuffer<true>::BufferBlock allocation_block;
   LocalMemoryRegion allocation_region;
 
   u64 local_num_result{0};
   u64 rdma_reads_in_bytes{0};
+  u64 rdma_writes_in_bytes{0};
   u64 processed_queries{0};
   u64 remote_allocations{0};
   u64 remote_deallocations{0};
   u64 block_repeated_reads{0};
   u64 list_repeated_reads{0};
+  u64 insert_commits{0};  // lock/WRITE cycles of inserts
+  u64 tail_hint_hits{0};
+  u64 tail_hint_misses{0};
+  u64 free_list_refills{0};
+  u64 free_list_cas_failed{0};
+  u64 pool_growths{0};
+  u64 slot_reservations{0};  // appends without locking the block
+  u64 reservation_failed{0};
+  u64 pipelined_inserts{0};  // inserts completed without blocking the thread
+  u64 pipeline_fallbacks{0};
+  u64 forwarded_updates{0};  // writes handed to the owner thread of a term
+  u64 delta_appends{0};
+  u64 delta_full{0};  // appends that fell back to in-place inserts
+  u64 delta_reads_in_bytes{0};
+  u64 compacted_entries{0};  // only the compaction thread
+  u64 ingested_postings{0};
+  u64 ingested_blocks{0};  // blocks spliced onto tails by bulk ingests
+  u64 merged_blocks{0};    // only the compaction thread
+  u64 cache_hits{0};       // cached blocks with an unchanged footer
+  u64 cache_stale{0};      // cached blocks READ again
+  u64 stale_locks_released{0};
+  u64 lost_locks{0};  // given up or released by others (with leases)
+  u64 stale_blocks{0};  // freed blocks READ by queries
+  u64 query_restarts{0};
+  u64 created_heads{0};  // of new terms published in the catalog
+  u64 catalog_pulls{0};  // heads of new terms published by others
+  u64 validated_blocks{0};
+  bool time_validation{false};
+  u64 timed_validations{0};
+  u64 validation_time_ns{0};
+
+  // contention of block locks and free list heads
+  Backoff backoff;
+  LockLease lock_lease;
+  RetryHistogram lock_retries;
+  RetryHistogram free_list_retries;
+
+  // encoded remote pointers to blocks allocated for splits, but not yet used
+  vec<u64> split_blocks;
 
   i32 post_balance{0};
   i32 post_balance_CAS{0};
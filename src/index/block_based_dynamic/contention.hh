@@ -0,0 +1,119 @@
+#ifndef INDEX_BLOCK_BASED_DYNAMIC_CONTENTION_HH
+#define INDEX_BLOCK_BASED_DYNAMIC_CONTENTION_HH
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <library/types.hh>
+#include <random>
+
+#include "index/constants.hh"
+
+namespace inv_index::block_based::dynamic {
+
+// failed CASs per successful one in power-of-two buckets: 0, 1, 2-3, 4-7, ...
+// (the last bucket holds all larger counts)
+struct RetryHistogram {
+  u32 retries{0};  // of the current operation
+  std::array<u64, CONTENTION_BUCKETS> buckets{};
+
+  void add_retry() { ++retries; }
+
+  // the operation gives up, its retries must not delay the next one
+  void abandon() { retries = 0; }
+
+  void add_success() {
+    ++buckets[get_bucket(retries)];
+    retries = 0;
+  }
+
+  static u32 get_bucket(u32 retries) {
+    u32 bucket = 0;
+    while (retries > 0 && bucket + 1 < CONTENTION_BUCKETS) {
+      retries >>= 1;
+      ++bucket;
+    }
+
+    return bucket;
+  }
+};
+
+// randomized exponential backoff before retrying a failed CAS, the delay is
+// drawn from [0, min(max_ns, BACKOFF_BASE_NS * 2^retries)] (busy waiting,
+// since the delays are far below a scheduler time slice)
+class Backoff {
+public:
+  void set_max_ns(u32 max_ns) { max_ns_ = max_ns; }
+
+  void wait(u32 retries) {
+    if (max_ns_ == 0) {
+      return;
+    }
+
+    const u64 limit = std::min<u64>(
+      max_ns_, static_cast<u64>(BACKOFF_BASE_NS) << std::min<u32>(retries, 20));
+    const u64 delay =
+      std::uniform_int_distribution<u64>(0, limit)(generator_);
+
+    const auto until =
+      std::chrono::steady_clock::now() + std::chrono::nanoseconds(delay);
+    while (std::chrono::steady_clock::now() < until) {
+    }
+
+    waited_ns += delay;
+  }
+
+public:
+  u64 waited_ns{0};
+
+private:
+  u32 max_ns_{0};  // 0 disables backoff
+  std::mt19937 generator_{std::random_device{}()};
+};
+
+// a lock whose footer word does not change for longer than the lease is
+// considered stale, i.e., its holder has failed, holders swap their locked
+// word before WRITing the block, i.e., a holder whose lock has been released
+// notices it (a holder that fails while WRITing keeps the block locked)
+class LockLease {
+  using Clock = std::chrono::steady_clock;
+
+public:
+  void set_lease_us(u32 lease_us) { lease_us_ = lease_us; }
+  bool is_enabled() const { return lease_us_ > 0; }
+
+  void acquire() { held_locks_++; }
+  void release() { --held_locks_; }
+  bool holds_lock() const { return held_locks_ > 0; }
+
+  // returns true if the locked word has been observed for longer than the
+  // lease (by the calling thread)
+  bool is_expired(u64 locked_word) {
+    if (lease_us_ == 0) {
+      return false;
+    }
+
+    const auto now = Clock::now();
+    if (locked_word != word_) {
+      word_ = locked_word;
+      since_ = now;
+      return false;
+    }
+
+    return now - since_ > std::chrono::microseconds(lease_us_);
+  }
+
+  // the next holder of a released lock might lock the same word
+  void forget() { word_ = 0; }
+
+private:
+  u32 lease_us_{0};  // 0 disables leases
+  u64 word_{0};      // last observed locked word
+  Clock::time_point since_;
+
+  u32 held_locks_{0};  // by the calling thread
+};
+
+}  // namespace inv_index::block_based::dynamic
+
+#endif  // INDEX_BLOCK_BASED_DYNAMIC_CONTENTION_HH
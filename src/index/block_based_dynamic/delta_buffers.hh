@@ -0,0 +1,258 @@
+#ifndef INDEX_BLOCK_BASED_DYNAMIC_DELTA_BUFFERS_HH
+#define INDEX_BLOCK_BASED_DYNAMIC_DELTA_BUFFERS_HH
+
+#include <algorithm>
+#include <library/memory_region.hh>
+#include <library/types.hh>
+
+#include "compute_thread.hh"
+#include "delta_layout.hh"
+#include "index/constants.hh"
+
+namespace inv_index::block_based::dynamic {
+
+// inserts are appended to per-term delta logs in remote memory instead of
+// updating the blocks in place; readers merge the logs with the blocks, and a
+// single compaction thread switches the epoch of a log and folds its entries
+// into the blocks, the log is reset only after the entries are in the blocks
+class DeltaBuffers {
+public:
+  DeltaBuffers(u32 capacity,
+               u32 universe_size,
+               MemoryRegionTokens& delta_tokens)
+      : num_servers_(delta_tokens.size()),
+        layout_{capacity,
+                DeltaLayout::get_num_terms(universe_size, num_servers_)},
+        delta_tokens_(delta_tokens) {}
+
+  u32 get_log_entries() const { return 2 * layout_.capacity; }
+
+  // reserves a position in the current log of the term (FAA) and WRITEs the
+  // id into it, returns false if the log is full
+  bool append(u32 term, u32 id, u_ptr<ComputeThread>& thread) {
+    const u32 node = term % num_servers_;
+    const u32 idx = term / num_servers_;
+    QP& qp = thread->qps[node]->qp;
+    MemoryRegionToken* token = delta_tokens_[node].get();
+
+    thread->post_balance++;
+    thread->post_balance_CAS++;
+    qp->post_FAA(
+      thread->cas_region, token, layout_.get_counter_offset(idx), 1);
+
+    while (thread->post_balance_CAS > 0) {
+      thread->poll_cq_and_handle();
+    }
+
+    // FAA writes the old value into the buffer
+    const u64 counter = thread->cas_buffer;
+    const u64 pos = DeltaLayout::get_count(counter);
+    if (pos >= layout_.capacity) {
+      thread->delta_full++;
+      return false;
+    }
+
+    thread->post_balance++;
+    thread->rdma_writes_in_bytes += sizeof(u32);
+    qp->post_send_inlined(
+      std::addressof(id),
+      sizeof(u32),
+      IBV_WR_RDMA_WRITE,
+      true,
+      token,
+      layout_.get_log_offset(idx, DeltaLayout::get_epoch(counter)) +
+        pos * sizeof(u32),
+      0,
+      WR_WRITE_DELTA);
+
+    thread->delta_appends++;
+    return true;
+  }
+
+  // READs both logs of the term into column col
+  void READ(u32 term, u32 col, u_ptr<ComputeThread>& thread) {
+    const u32 node = term % num_servers_;
+    const u32 size = get_log_entries() * sizeof(u32);
+
+    thread->post_balance++;
+    thread->rdma_reads_in_bytes += size;
+    thread->delta_reads_in_bytes += size;
+
+    thread->qps[node]->qp->post_send(
+      reinterpret_cast<u64>(thread->get_delta_log(col)),
+      size,
+      thread->delta_region->get_lkey(),
+      IBV_WR_RDMA_READ,
+      true,
+      false,
+      delta_tokens_[node].get(),
+      layout_.get_log_offset(term / num_servers_, 0),
+      0,
+      WR_READ_NO_HANDLE);
+  }
+
+  // ordered and unique entries of both logs READ into column col
+  void collect(u32 col, u_ptr<ComputeThread>& thread, vec<u32>& entries) {
+    const u32* log = thread->get_delta_log(col);
+    entries.clear();
+
+    std::copy_if(log,
+                 log + get_log_entries(),
+                 std::back_inserter(entries),
+                 [](u32 entry) { return entry != DeltaLayout::TOMBSTONE; });
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+  }
+
+  // folds all non-empty logs into the blocks (compaction thread only)
+  template <typename F>
+  void compact(u_ptr<ComputeThread>& thread, F inserter) {
+    if (!counter_region_) {
+      counters_.resize(std::min(layout_.num_terms, DELTA_COUNTER_CHUNK));
+      counter_region_ = std::make_unique<LocalMemoryRegion>(
+        thread->local_context,
+        counters_.data(),
+        counters_.size() * sizeof(u64));
+    }
+
+    for (u32 node = 0; node < num_servers_; ++node) {
+      for (u32 first = 0; first < layout_.num_terms;
+           first += counters_.size()) {
+        const u32 num_counters =
+          std::min<u32>(counters_.size(), layout_.num_terms - first);
+        READ_counters(node, first, num_counters, thread);
+
+        for (u32 i = 0; i < num_counters; ++i) {
+          if (DeltaLayout::get_count(counters_[i]) > 0) {
+            compact_log(node, first + i, counters_[i], thread, inserter);
+          }
+        }
+      }
+    }
+  }
+
+private:
+  void READ_counters(u32 node,
+                     u32 first,
+                     u32 num_counters,
+                     u_ptr<ComputeThread>& thread) {
+    thread->post_balance++;
+    thread->rdma_reads_in_bytes += num_counters * sizeof(u64);
+
+    thread->qps[node]->qp->post_send(
+      reinterpret_cast<u64>(counters_.data()),
+      num_counters * sizeof(u64),
+      counter_region_->get_lkey(),
+      IBV_WR_RDMA_READ,
+      true,
+      false,
+      delta_tokens_[node].get(),
+      layout_.get_counter_offset(first),
+      0,
+      WR_READ_NO_HANDLE);
+
+    while (thread->post_balance > 0) {
+      thread->poll_cq_and_handle();
+    }
+  }
+
+  template <typename F>
+  void compact_log(u32 node,
+                   u32 idx,
+                   u64 counter,
+                   u_ptr<ComputeThread>& thread,
+                   F inserter) {
+    QP& qp = thread->qps[node]->qp;
+    MemoryRegionToken* token = delta_tokens_[node].get();
+
+    // switch the epoch, subsequent appends go to the other (empty) log
+    while (true) {
+      const u64 swap = ~counter & DeltaLayout::EPOCH_BIT;
+
+      thread->post_balance++;
+      thread->post_balance_CAS++;
+      qp->post_CAS(thread->cas_region,
+                   token,
+                   layout_.get_counter_offset(idx),
+                   counter,
+                   swap);
+
+      while (thread->post_balance_CAS > 0) {
+        thread->poll_cq_and_handle();
+      }
+
+      if (thread->cas_buffer == counter) {
+        break;
+      }
+
+      counter = thread->cas_buffer;
+    }
+
+    const u32 epoch = DeltaLayout::get_epoch(counter);
+    const u32 num_entries =
+      std::min<u64>(DeltaLayout::get_count(counter), layout_.capacity);
+    const u64 log_offset = layout_.get_log_offset(idx, epoch);
+    const u32 size = num_entries * sizeof(u32);
+    u32* log = thread->get_delta_log(0);
+
+    // appends may have reserved a position but not yet WRITten it
+    do {
+      thread->post_balance++;
+      thread->rdma_reads_in_bytes += size;
+      qp->post_send(reinterpret_cast<u64>(log),
+                    size,
+                    thread->delta_region->get_lkey(),
+                    IBV_WR_RDMA_READ,
+                    true,
+                    false,
+                    token,
+                    log_offset,
+                    0,
+                    WR_READ_NO_HANDLE);
+
+      while (thread->post_balance > 0) {
+        thread->poll_cq_and_handle();
+      }
+    } while (std::find(log, log + num_entries, DeltaLayout::TOMBSTONE) !=
+             log + num_entries);
+
+    vec<u32> ids(log, log + num_entries);
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    inserter(idx * num_servers_ + node, ids);
+
+    // reset the log for its next epoch
+    std::fill_n(log, num_entries, DeltaLayout::TOMBSTONE);
+    thread->post_balance++;
+    thread->rdma_writes_in_bytes += size;
+    qp->post_send(reinterpret_cast<u64>(log),
+                  size,
+                  thread->delta_region->get_lkey(),
+                  IBV_WR_RDMA_WRITE,
+                  true,
+                  false,
+                  token,
+                  log_offset,
+                  0,
+                  WR_WRITE_DELTA);
+
+    while (thread->post_balance > 0) {
+      thread->poll_cq_and_handle();
+    }
+
+    thread->compacted_entries += num_entries;
+  }
+
+private:
+  const u32 num_servers_;
+  const DeltaLayout layout_;
+  MemoryRegionTokens& delta_tokens_;
+
+  // counters READ by the compaction thread
+  vec<u64> counters_;
+  u_ptr<LocalMemoryRegion> counter_region_;
+};
+
+}  // namespace inv_index::block_based::dynamic
+
+#endif  // INDEX_BLOCK_BASED_DYNAMIC_DELTA_BUFFERS_HH
@@ -0,0 +1,48 @@
+#ifndef INDEX_BLOCK_BASED_DYNAMIC_DELTA_LAYOUT_HH
+#define INDEX_BLOCK_BASED_DYNAMIC_DELTA_LAYOUT_HH
+
+#include <algorithm>
+#include <library/types.hh>
+
+namespace inv_index::block_based::dynamic {
+
+// per-term delta logs of a memory node (term t is hosted by memory node
+// t % num_servers at index t / num_servers):
+// counter0 (64) | counter1 (64) | ... | term0-log0 | term0-log1 | term1-log0
+// a counter is [ epoch (1) | count (63) ], appends reserve a position in the
+// log of the current epoch, unused positions hold a tombstone
+struct DeltaLayout {
+  static constexpr u64 EPOCH_BIT = static_cast<u64>(1) << 63;
+  static constexpr u32 TOMBSTONE = static_cast<u32>(-1);
+
+  u32 capacity;   // entries per log
+  u32 num_terms;  // terms hosted by the memory node
+
+  u64 get_counter_offset(u32 idx) const { return idx * sizeof(u64); }
+
+  u64 get_log_offset(u32 idx, u32 epoch) const {
+    return num_terms * sizeof(u64) +
+           (2 * static_cast<u64>(idx) + epoch) * capacity * sizeof(u32);
+  }
+
+  u64 get_size() const { return get_log_offset(num_terms, 0); }
+
+  void initialize(byte* buffer) const {
+    std::fill_n(reinterpret_cast<u64*>(buffer), num_terms, 0);
+    std::fill_n(reinterpret_cast<u32*>(buffer + get_log_offset(0, 0)),
+                2 * static_cast<u64>(num_terms) * capacity,
+                TOMBSTONE);
+  }
+
+  // terms hosted by each of num_servers memory nodes
+  static u32 get_num_terms(u32 universe_size, u32 num_servers) {
+    return (universe_size + num_servers) / num_servers;
+  }
+
+  static u32 get_epoch(u64 counter) { return counter >> 63; }
+  static u64 get_count(u64 counter) { return counter & ~EPOCH_BIT; }
+};
+
+}  // namespace inv_index::block_based::dynamic
+
+#endif  // INDEX_BLOCK_BASED_DYNAMIC_DELTA_LAYOUT_HH
@@ -0,0 +1,73 @@
+#ifndef INDEX_BLOCK_BASED_DYNAMIC_EPOCH_RECLAMATION_HH
+#define INDEX_BLOCK_BASED_DYNAMIC_EPOCH_RECLAMATION_HH
+
+#include <algorithm>
+#include <atomic>
+#include <library/types.hh>
+
+#include "block_pool.hh"
+#include "compute_thread.hh"
+#include "remote_pointer.hh"
+
+namespace inv_index::block_based::dynamic {
+
+// blocks unlinked by writes are not pushed onto the free lists right away, a
+// query of this compute node might still follow a pointer to them: a block
+// retired in epoch e is freed once no query that started in an epoch <= e is
+// running (queries of other compute nodes detect reused blocks by their tags
+// and are restarted)
+class EpochReclamation {
+public:
+  explicit EpochReclamation(BlockPools& block_pools)
+      : block_pools_(block_pools) {}
+
+  // all threads that run queries (before they start)
+  void add_thread(ComputeThread* thread) { threads_.push_back(thread); }
+
+  // a query holds pointers to blocks from enter to leave
+  void enter(u_ptr<ComputeThread>& thread) {
+    thread->query_epoch = epoch_.load();
+  }
+
+  void leave(u_ptr<ComputeThread>& thread) { thread->query_epoch = QUIESCENT; }
+
+  // each retired block starts a new epoch
+  void retire(RemotePtr r, u_ptr<ComputeThread>& thread) {
+    thread->retired_blocks.emplace_back(
+      epoch_.fetch_add(1),
+      RemotePtr::encode_remote_ptr(0, r.memory_node, r.offset));
+
+    if (thread->retired_blocks.size() >= RECLAIM_BATCH) {
+      reclaim(thread);
+    }
+  }
+
+  // frees the retired blocks of the thread that no query can READ anymore
+  // (all of them once the queries are done)
+  void reclaim(u_ptr<ComputeThread>& thread) {
+    u64 oldest = QUIESCENT;
+    for (ComputeThread* t : threads_) {
+      oldest = std::min<u64>(oldest, t->query_epoch);
+    }
+
+    // the blocks of a thread are retired in increasing epochs
+    auto& retired = thread->retired_blocks;
+    auto end = retired.begin();
+    for (; end != retired.end() && end->first < oldest; ++end) {
+      auto [tag, node, offs] = RemotePtr::decode_remote_ptr(end->second);
+      block_pools_[node]->deallocate(
+        static_cast<u64>(offs) * RemotePtr::block_size, thread);
+    }
+
+    retired.erase(retired.begin(), end);
+  }
+
+private:
+  BlockPools& block_pools_;
+  vec<ComputeThread*> threads_;
+  std::atomic<u64> epoch_{0};
+};
+
+}  // namespace inv_index::block_based::dynamic
+
+#endif  // INDEX_BLOCK_BASED_DYNAMIC_EPOCH_RECLAMATION_HH
@@ -1,6 +1,7 @@
 #ifndef INDEX_BLOCK_BASED_DYNAMIC_FREE_LIST_HH
 #define INDEX_BLOCK_BASED_DYNAMIC_FREE_LIST_HH
 
+#include <algorithm>
 #include <iostream>
 #include <library/types.hh>
 #include <random>
@@ -9,32 +10,43 @@
 
 namespace inv_index::block_based::dynamic::freelist {
 
-// one free list per memory node that looks as follows:
+// one free list per segment of a memory node that looks as follows:
 // head (64) | block0-next (32) | block1-next (32) | ...
+// a head is [ counter (32) | block (32) ], every claim and push increases the
+// counter s.t. a head CAS fails if the block has been claimed and pushed back
+// meanwhile (with a different next pointer)
 class FreeList {
 public:
   FreeList(u32 block_size,
            u32 memory_node,
+           u32 first_block,
            u32 offset,
            MRT& remote_access_token)
       : block_size_(block_size),
         memory_node_(memory_node),
+        first_block_(first_block),
         offset_(offset),
         access_token_(remote_access_token) {
     // initialize PRNG
     dist_ = std::uniform_int_distribution<u32>(0, FREELIST_PARTITIONS - 1);
   }
 
-  // returns the (raw) remote offset to the allocated buffer
-  u64 allocate(u_ptr<ComputeThread>& thread) {
-    thread->remote_allocations++;
+  // detaches a run of free blocks from a partition with a single CAS,
+  // the run is bounded by the window of next pointers READ after the head,
+  // returns false if all partitions are empty
+  bool claim_run(u_ptr<ComputeThread>& thread) {
+    thread->free_list_refills++;
 
     auto& flb = thread->free_list_buffers[memory_node_];
     QP& qp = thread->qps[memory_node_]->qp;
-    u32 head;
+    auto& cached_blocks = flb->cached_blocks;
 
-    do {
-      const u64 head_offset = get_random_head_offset();
+    u32 partition = dist_(generator_);
+    u32 empty_partitions = 0;
+
+    while (true) {
+      const u64 head_offset =
+        get_first_head_offset() + partition * sizeof(u64);
 
       // READ head
       thread->post_balance++;
@@ -51,33 +63,49 @@ public:
         thread->poll_cq_and_handle();
       }
 
-      head = flb->buffers.head;
-      lib_assert(head != TOMBSTONE, "memory node out of memory");
+      const u64 head_word = flb->buffers.head;
+      const u32 head = get_block(head_word);
+      if (head == TOMBSTONE) {
+        if (++empty_partitions == FREELIST_PARTITIONS) {
+          return false;
+        }
+
+        partition = (partition + 1) % FREELIST_PARTITIONS;
+        continue;
+      }
 
-      // READ head->next
+      // READ the next pointers of the blocks following the head
+      const u32 window_length = std::min<u32>(FREELIST_WINDOW, offset_ - head);
       thread->post_balance++;
-      qp->post_send_with_id(flb->memory_region,
-                            sizeof(u32),
+      qp->post_send_with_id(flb->window_region,
+                            window_length * sizeof(u32),
                             IBV_WR_RDMA_READ,
                             WR_READ_NO_HANDLE,
                             true,
                             access_token_.get(),
-                            get_head_next_offset(head),
-                            sizeof(u64));
+                            get_head_next_offset(head));
 
-      // wait for head->next
       while (thread->post_balance > 0) {
         thread->poll_cq_and_handle();
       }
 
-      // swap head with head->next
+      // follow the chain as long as it stays within the window
+      cached_blocks.clear();
+      u32 block = head;
+      while (cached_blocks.size() < FREELIST_RUN_LENGTH && block != TOMBSTONE &&
+             block - head < window_length) {
+        cached_blocks.push_back(block);
+        block = flb->window[block - head];
+      }
+
+      // swap head with the successor of the run
       thread->post_balance++;
       thread->post_balance_CAS++;
       qp->post_CAS(flb->memory_region,
                    access_token_.get(),
                    head_offset,
-                   head,
-                   flb->buffers.head_next);
+                   head_word,
+                   get_next_head_word(head_word, block));
 
       // synchronous CAS
       while (thread->post_balance_CAS > 0) {
@@ -85,19 +113,22 @@ public:
       }
 
       // CAS writes the old value into the buffer
-    } while (flb->buffers.head != head);
+      if (flb->buffers.head == head_word) {
+        thread->free_list_retries.add_success();
+        return true;
+      }
 
-    return flb->buffers.head * block_size_;
+      thread->free_list_cas_failed++;
+      thread->free_list_retries.add_retry();
+      thread->backoff.wait(thread->free_list_retries.retries);
+    }
   }
 
-  void deallocate(u64 raw_offset, u_ptr<ComputeThread>& thread) {
-    thread->remote_deallocations++;
-
+  // pushes a single block onto a random partition
+  void push_block(u32 new_head, u_ptr<ComputeThread>& thread) {
     auto& flb = thread->free_list_buffers[memory_node_];
     QP& qp = thread->qps[memory_node_]->qp;
-
-    u32 new_head = raw_offset / block_size_;
-    u32 current_head;
+    u64 head_word;
 
     const u64 head_offset = get_random_head_offset();
 
@@ -117,7 +148,8 @@ public:
         thread->poll_cq_and_handle();
       }
 
-      current_head = flb->buffers.head;
+      head_word = flb->buffers.head;
+      const u32 current_head = get_block(head_word);
 
       // WRITE current-head as next-ptr to new-head
       //      thread->post_balance++;
@@ -134,20 +166,29 @@ public:
       qp->post_CAS(flb->memory_region,
                    access_token_.get(),
                    head_offset,
-                   current_head,
-                   new_head);
+                   head_word,
+                   get_next_head_word(head_word, new_head));
 
       // synchronous CAS
       while (thread->post_balance_CAS > 0) {
         thread->poll_cq_and_handle();
       }
+
       // CAS writes the old value into the buffer
-    } while (flb->buffers.head != current_head);
+      if (flb->buffers.head != head_word) {
+        thread->free_list_cas_failed++;
+        thread->free_list_retries.add_retry();
+        thread->backoff.wait(thread->free_list_retries.retries);
+      }
+    } while (flb->buffers.head != head_word);
+
+    thread->free_list_retries.add_success();
   }
 
-private:
-  u64 get_address() const {
-    return access_token_->address + static_cast<u64>(offset_) * block_size_;
+  static u32 get_block(u64 head_word) { return static_cast<u32>(head_word); }
+
+  static u64 get_next_head_word(u64 head_word, u32 block) {
+    return ((head_word >> 32) + 1) << 32 | block;
   }
 
   u64 get_first_head_offset() const {
@@ -161,12 +202,13 @@ private:
 
   u64 get_head_next_offset(u32 head) const {
     return get_first_head_offset() + sizeof(u64) * FREELIST_PARTITIONS +
-           head * sizeof(u32);
+           static_cast<u64>(head - first_block_) * sizeof(u32);
   }
 
 private:
   const u32 block_size_;
   const u32 memory_node_;
+  const u32 first_block_;
   const u32 offset_;
 
   MRT& access_token_;
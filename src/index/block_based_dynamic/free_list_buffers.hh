@@ -3,6 +3,9 @@
 
 #include <library/memory_region.hh>
 
+#include "index/constants.hh"
+#include "segment_table.hh"
+
 namespace inv_index::block_based::dynamic::freelist {
 constexpr static u32 TOMBSTONE = static_cast<u32>(-1);
 
@@ -15,8 +18,23 @@ struct FreeListBuffers {
   Buffers buffers{};
   LocalMemoryRegion memory_region;
 
+  // next pointers following a claimed head
+  vec<u32> window = vec<u32>(FREELIST_WINDOW);
+  LocalMemoryRegion window_region;
+
+  vec<u32> cached_blocks;  // claimed but not yet used
+
+  // segments of the memory node and the reply to control messages
+  SegmentTable table{};
+  LocalMemoryRegion table_region;
+  u32 reply{};
+  LocalMemoryRegion reply_region;
+
   explicit FreeListBuffers(Context& context)
-      : memory_region(context, std::addressof(buffers), sizeof(Buffers)) {}
+      : memory_region(context, std::addressof(buffers), sizeof(Buffers)),
+        window_region(context, window.data(), window.size() * sizeof(u32)),
+        table_region(context, std::addressof(table), sizeof(SegmentTable)),
+        reply_region(context, std::addressof(reply), sizeof(u32)) {}
 };
 
 }  // namespace inv_index::block_based::dynamic::freelist
@@ -1,6 +1,7 @@
 #ifndef INDEX_BLOCK_BASED_DYNAMIC_INSERT_HH
 #define INDEX_BLOCK_BASED_DYNAMIC_INSERT_HH
 
+#include <algorithm>
 #include <library/types.hh>
 
 #include "index/constants.hh"
@@ -65,8 +66,19 @@ u32 binary_search_cacheline(const u32* buffer,
   return first;
 }
 
-// we assert that there is at least one free space
-void ordered_insert(u32* buffer, u32 value, u32 free_pos, u32 block_size) {
+// we assert that there is at least one free space, returns the position
+u32 ordered_insert(u32* buffer, u32 value, u32 free_pos, u32 block_size) {
+  // without cache line versions the entries are contiguous
+  if constexpr (!CACHE_LINE_VERSIONS) {
+    const u32 buffer_pos =
+      std::lower_bound(buffer, buffer + free_pos, value) - buffer;
+    std::copy_backward(
+      buffer + buffer_pos, buffer + free_pos, buffer + free_pos + 1);
+
+    buffer[buffer_pos] = value;
+    return buffer_pos;
+  }
+
   const u32 num_cache_lines = block_size / CACHE_LINE_SIZE;
   const u32 cl = binary_search_block(buffer, value, num_cache_lines);
   const u32 pos_in_cl =
@@ -84,6 +96,7 @@ void ordered_insert(u32* buffer, u32 value, u32 free_pos, u32 block_size) {
   }
 
   buffer[buffer_pos] = value;
+  return buffer_pos;
 }
 
 }  // namespace inv_index::block_based::dynamic
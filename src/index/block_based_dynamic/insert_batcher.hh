@@ -0,0 +1,46 @@
+#ifndef INDEX_BLOCK_BASED_DYNAMIC_INSERT_BATCHER_HH
+#define INDEX_BLOCK_BASED_DYNAMIC_INSERT_BATCHER_HH
+
+#include <algorithm>
+#include <library/types.hh>
+#include <map>
+
+namespace inv_index::block_based::dynamic {
+
+// collects pending inserts of a compute thread grouped by term
+class InsertBatcher {
+public:
+  explicit InsertBatcher(u32 max_pending) : max_pending_(max_pending) {}
+
+  void add(u32 term, u32 id) {
+    pending_[term].push_back(id);
+    ++num_pending_;
+  }
+
+  bool is_full() const { return num_pending_ >= max_pending_; }
+  bool is_empty() const { return num_pending_ == 0; }
+
+  // hands the ordered and unique ids of each term to the inserter
+  template <typename F>
+  void flush(F inserter) {
+    for (auto& [term, ids] : pending_) {
+      std::sort(ids.begin(), ids.end());
+      ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+      inserter(term, ids);
+    }
+
+    pending_.clear();
+    num_pending_ = 0;
+  }
+
+private:
+  const u32 max_pending_;
+
+  std::map<u32, vec<u32>> pending_;  // term -> ids
+  u32 num_pending_{0};
+};
+
+}  // namespace inv_index::block_based::dynamic
+
+#endif  // INDEX_BLOCK_BASED_DYNAMIC_INSERT_BATCHER_HH
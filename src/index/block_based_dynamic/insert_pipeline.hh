@@ -0,0 +1,291 @@
+#ifndef INDEX_BLOCK_BASED_DYNAMIC_INSERT_PIPELINE_HH
+#define INDEX_BLOCK_BASED_DYNAMIC_INSERT_PIPELINE_HH
+
+#include <library/types.hh>
+#include <library/utils.hh>
+
+#include "block_pool.hh"
+#include "compute_thread.hh"
+#include "remote_pointer.hh"
+
+namespace inv_index::block_based::dynamic {
+
+// keeps several inserts (of different terms) of a compute thread in flight,
+// every slot owns a read buffer column and advances on its own completions:
+// the list is READ up to the tail, where a slot is reserved (CAS) and the id
+// is WRITten into it; inserts requiring a lock are completed synchronously
+template <typename F>
+class InsertPipeline {
+  using BufferBlock = ReadBuffer<true>::BufferBlock;
+
+  enum class State { FREE, READING, RESERVING, WRITING };
+
+  struct Slot {
+    State state{State::FREE};
+    u32 term{};
+    u32 id{};
+
+    // current block of the list
+    u32 row{};
+    u32 node{};
+    u32 offs{};
+    u16 expected_tag{};
+
+    u64 hint{};
+    bool from_tail{};
+
+    // reserved slot in the tail block
+    u64 compare{};
+    u32 insert_pos{};
+  };
+
+public:
+  InsertPipeline(u32 depth,
+                 RemotePointers& remote_pointers,
+                 TailHints& tail_hints,
+                 BlockPools& block_pools,
+                 u_ptr<ComputeThread>& thread,
+                 F allocate_block)
+      : slots_(depth),
+        remote_pointers_(remote_pointers),
+        tail_hints_(tail_hints),
+        block_pools_(block_pools),
+        thread_(thread),
+        allocate_block_(allocate_block) {
+    lib_assert(depth > 0 && depth <= READ_BUFFER_LENGTH,
+               "insert pipeline exceeds read buffer length");
+  }
+
+  // inserts of the same term are not overlapped (they would fail on the
+  // reservations of each other)
+  void submit(u32 term, u32 id) {
+    while (is_in_flight(term)) {
+      progress();
+    }
+
+    while (true) {
+      for (u32 s = 0; s < slots_.size(); ++s) {
+        if (slots_[s].state == State::FREE) {
+          slots_[s].term = term;
+          slots_[s].id = id;
+          start(s);
+
+          return;
+        }
+      }
+
+      progress();
+    }
+  }
+
+  // completes all inserts in flight
+  void drain() {
+    while (!is_empty()) {
+      progress();
+    }
+  }
+
+  bool is_empty() const {
+    for (const Slot& slot : slots_) {
+      if (slot.state != State::FREE) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+private:
+  bool is_in_flight(u32 term) const {
+    for (const Slot& slot : slots_) {
+      if (slot.state != State::FREE && slot.term == term) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  void progress() {
+    thread_->poll_cq_and_handle();
+
+    for (u32 s = 0; s < slots_.size(); ++s) {
+      advance(s);
+    }
+  }
+
+  // starts READing the list at the hinted tail or at the head
+  void start(u32 s) {
+    Slot& slot = slots_[s];
+    const RemotePtr& head = remote_pointers_[slot.term];
+
+    slot.expected_tag = head.tag;
+    slot.node = head.memory_node;
+    slot.offs = head.offset;
+    slot.row = 0;
+
+    slot.hint = tail_hints_[slot.term];
+    slot.from_tail = slot.hint != RemotePtr::NO_TAIL_HINT;
+    if (slot.from_tail) {
+      std::tie(slot.expected_tag, slot.node, slot.offs) =
+        RemotePtr::decode_remote_ptr(slot.hint);
+    }
+
+    READ(s);
+  }
+
+  void READ(u32 s) {
+    Slot& slot = slots_[s];
+
+    // prevent WR overflow
+    while (thread_->post_balance == thread_->get_max_send_queue_wr()) {
+      thread_->poll_cq_and_handle();
+    }
+
+    slot.state = State::READING;
+    RemotePtr p{slot.node, slot.offs};
+    p.READ_block(s, slot.row, block_pools_, thread_);
+  }
+
+  void advance(u32 s) {
+    Slot& slot = slots_[s];
+    auto& block = thread_->read_buffer.get_block(s, slot.row);
+
+    switch (slot.state) {
+    case State::READING:
+      // locked or torn blocks are READ again by the completion handler
+      if (block.ready) {
+        on_block(s, block);
+      }
+      break;
+    case State::RESERVING:
+      if (!thread_->slot_cas_pending[s]) {
+        on_reservation(s, block);
+      }
+      break;
+    case State::WRITING:
+      if (!block.just_writing) {
+        slot.state = State::FREE;
+        thread_->insert_commits++;
+        thread_->pipelined_inserts++;
+      }
+      break;
+    case State::FREE:
+      break;
+    }
+  }
+
+  void on_block(u32 s, BufferBlock& block) {
+    Slot& slot = slots_[s];
+    std::atomic<u64>& tail_hint = tail_hints_[slot.term];
+
+    // block has been re-used meanwhile, re-start READing the list
+    if (block.get_block_tag() != slot.expected_tag) {
+      if (slot.from_tail) {
+        RemotePtr::drop_tail_hint(tail_hint, slot.hint, thread_);
+      } else {
+        thread_->list_repeated_reads++;
+      }
+
+      start(s);
+      return;
+    }
+
+    // the id may belong to a previous block, start at the head instead
+    if (slot.from_tail) {
+      if (!block.is_empty() && slot.id <= std::get<1>(block.get_min_max())) {
+        RemotePtr::drop_tail_hint(tail_hint, slot.hint, thread_);
+        start(s);
+        return;
+      }
+
+      thread_->tail_hint_hits++;
+      slot.from_tail = false;
+    }
+
+    const bool empty = block.is_empty();
+    auto [min, max, max_pos] = empty
+                                 ? std::make_tuple(static_cast<u32>(-1), 0u, 0u)
+                                 : block.get_min_max();
+
+    // move on to the next block
+    if ((empty || max < slot.id) && !block.points_to_null()) {
+      slot.expected_tag = block.get_remote_ptr_tag();
+      std::tie(slot.node, slot.offs) = block.get_remote_ptr();
+      slot.row = (slot.row + 1) % READ_BUFFER_DEPTH;
+
+      READ(s);
+      return;
+    }
+
+    // the tail has a free slot: reserve it asynchronously
+    if ((empty || max < slot.id) && !block.is_full()) {
+      slot.state = State::RESERVING;
+      slot.insert_pos = RemotePtr::get_append_pos(block);
+
+      thread_->slot_cas_pending[s] = true;
+      slot.compare = RemotePtr::post_reservation(
+        block,
+        thread_->qps[slot.node]->qp,
+        block_pools_[slot.node]->get_token(slot.offs, thread_),
+        slot.offs,
+        thread_,
+        thread_->slot_cas_region,
+        s * sizeof(u64),
+        WR_CAS_SLOT | s);
+
+      return;
+    }
+
+    // splits and ordered inserts lock the block, complete them synchronously
+    thread_->pipeline_fallbacks++;
+    slot.state = State::FREE;
+
+    RemotePtr& r_ptr = remote_pointers_[slot.term];
+    while (!r_ptr.find_block_and_insert(
+      slot.id, s, block_pools_, thread_, allocate_block_, tail_hint)) {
+    }
+  }
+
+  void on_reservation(u32 s, BufferBlock& block) {
+    Slot& slot = slots_[s];
+
+    if (thread_->slot_cas_buffers[s] != slot.compare) {
+      // reservation failed, we must reREAD the block
+      thread_->block_repeated_reads++;
+      thread_->reservation_failed++;
+
+      READ(s);
+      return;
+    }
+
+    MRT& mrt = block_pools_[slot.node]->get_token(slot.offs, thread_);
+
+    slot.state = State::WRITING;
+    block.buffer[slot.insert_pos] = slot.id;
+    RemotePtr::WRITE_entry(s,
+                           slot.row,
+                           slot.insert_pos,
+                           thread_->qps[slot.node]->qp,
+                           slot.offs,
+                           mrt,
+                           thread_);
+    thread_->slot_reservations++;
+
+    RemotePtr::set_tail_hint(
+      tail_hints_[slot.term], block, slot.node, slot.offs);
+  }
+
+private:
+  vec<Slot> slots_;
+
+  RemotePointers& remote_pointers_;
+  TailHints& tail_hints_;
+  BlockPools& block_pools_;
+  u_ptr<ComputeThread>& thread_;
+  F allocate_block_;
+};
+
+}  // namespace inv_index::block_based::dynamic
+
+#endif  // INDEX_BLOCK_BASED_DYNAMIC_INSERT_PIPELINE_HH
@@ -0,0 +1,112 @@
+#ifndef INDEX_BLOCK_BASED_DYNAMIC_LIST_EXPORT_HH
+#define INDEX_BLOCK_BASED_DYNAMIC_LIST_EXPORT_HH
+
+#include <algorithm>
+#include <fstream>
+#include <library/types.hh>
+#include <library/utils.hh>
+
+#include "block_pool.hh"
+#include "compute_thread.hh"
+#include "remote_pointer.hh"
+
+namespace inv_index::block_based::dynamic {
+
+// writes the lists in the binary format of the serializer (the input of the
+// partitioner): [ universe | num lists | term | list size | ids... | ... ],
+// returns the number of written postings
+inline u64 write_serialized_lists(const str& filename,
+                                  const vec<vec<u32>>& lists) {
+  std::ofstream output_s(filename, std::ios::out | std::ios::binary);
+  lib_assert(output_s.is_open(), "Cannot open '" + filename + "'");
+
+  const auto write_u32_buffer = [&](const u32* buffer, size_t size) {
+    lib_assert(output_s.write(reinterpret_cast<const char*>(buffer),
+                              size * sizeof(u32))
+                 .good(),
+               "Cannot write to '" + filename + "'");
+  };
+
+  const u32 num_lists = std::count_if(
+    lists.begin(), lists.end(), [](const auto& list) { return !list.empty(); });
+  const u32 header[] = {static_cast<u32>(lists.size() - 1), num_lists};
+  write_u32_buffer(header, 2);
+
+  u64 num_postings = 0;
+  for (u32 term = 0; term < lists.size(); ++term) {
+    const vec<u32>& list = lists[term];
+    if (list.empty()) {
+      continue;
+    }
+
+    const u32 list_header[] = {term, static_cast<u32>(list.size())};
+    write_u32_buffer(list_header, 2);
+    write_u32_buffer(list.data(), list.size());
+    num_postings += list.size();
+  }
+
+  // the final bytes are written on close
+  output_s.close();
+  return num_postings;
+}
+
+// READs a list block by block into an ordered and unique vector (the writes
+// must be quiesced, a list that changes meanwhile is READ again)
+class ListExport {
+public:
+  ListExport(RemotePointers& remote_pointers,
+             BlockPools& block_pools,
+             u_ptr<ComputeThread>& thread)
+      : remote_pointers_(remote_pointers),
+        block_pools_(block_pools),
+        thread_(thread) {}
+
+  void read(u32 term, vec<u32>& list) {
+    while (!try_read(term, list)) {
+      thread_->list_repeated_reads++;
+    }
+
+    std::sort(list.begin(), list.end());
+    list.erase(std::unique(list.begin(), list.end()), list.end());
+  }
+
+private:
+  bool try_read(u32 term, vec<u32>& list) {
+    u16 expected_tag = remote_pointers_[term].tag;  // of the head block
+    u32 node = remote_pointers_[term].memory_node;
+    u32 offs = remote_pointers_[term].offset;
+
+    list.clear();
+    for (u32 row = 0;; row = (row + 1) % READ_BUFFER_DEPTH) {
+      RemotePtr p{node, offs};
+      p.READ_block(0, row, block_pools_, thread_);
+
+      while (thread_->post_balance > 0) {
+        thread_->poll_cq_and_handle();
+      }
+
+      auto& block = thread_->read_buffer.get_block(0, row);
+      if (block.get_block_tag() != expected_tag) {
+        return false;
+      }
+
+      block.collect_entries(list);
+
+      if (block.points_to_null()) {
+        return true;
+      }
+
+      expected_tag = block.get_remote_ptr_tag();
+      std::tie(node, offs) = block.get_remote_ptr();
+    }
+  }
+
+private:
+  RemotePointers& remote_pointers_;
+  BlockPools& block_pools_;
+  u_ptr<ComputeThread>& thread_;
+};
+
+}  // namespace inv_index::block_based::dynamic
+
+#endif  // INDEX_BLOCK_BASED_DYNAMIC_LIST_EXPORT_HH
@@ -2,16 +2,29 @@
 #define INDEX_BLOCK_BASED_DYNAMIC_QUERY_HANDLER_HH
 
 #include <algorithm>
+#include <chrono>
 #include <library/batched_read.hh>
 #include <library/latch.hh>
+#include <optional>
 
+#include "block_merger.hh"
+#include "block_pool.hh"
+#include "bulk_ingest.hh"
 #include "compute_thread.hh"
+#include "delta_buffers.hh"
+#include "epoch_reclamation.hh"
 #include "data_processing/serializer/deserializer.hh"
-#include "free_list.hh"
+#include "index/block_based/block_counts.hh"
 #include "index/block_based/block_operations.hh"
 #include "index/configuration.hh"
 #include "index/query/query.hh"
+#include "index/query/query_stream.hh"
+#include "index/query/term_owners.hh"
+#include "insert_batcher.hh"
+#include "insert_pipeline.hh"
+#include "list_export.hh"
 #include "remote_pointer.hh"
+#include "term_catalog.hh"
 
 namespace inv_index::block_based::dynamic {
 
@@ -19,8 +32,10 @@ class DynamicBlockBasedQueryHandler {
 public:
   using Configuration = configuration::IndexConfiguration;
   using ComputeThreads = vec<u_ptr<ComputeThread>>;
-  using Queue = concurrent_queue<u32>;
-  inline static const str name = "dynamic_block";
+  using Queue = query::QueryStream;
+  // crc blocks have a different layout (and index files)
+  inline static const str name =
+    CACHE_LINE_VERSIONS ? "dynamic_block" : "dynamic_crc_block";
 
 public:
   DynamicBlockBasedQueryHandler(u32 num_compute_threads,
@@ -35,28 +50,114 @@ public:
 
     // initialize static member
     RemotePtr::block_size = block_size;
+
+    // the fill count of a block has 15 bits
+    lib_assert(block_size / sizeof(u32) < (1u << 15),
+               "block size exceeds the fill count");
   }
 
-  void assign_free_lists(const vec<u32>& free_list_offsets,
-                         MemoryRegionTokens& remote_access_tokens) {
+  void assign_block_pools(const vec<u32>& free_list_offsets,
+                          MemoryRegionTokens& remote_access_tokens,
+                          MemoryRegionTokens& segment_table_tokens) {
     const u32 num_servers = remote_access_tokens.size();
-    free_lists_.reserve(num_servers);
+    block_pools_.reserve(num_servers);
 
     for (u32 memory_node = 0; memory_node < num_servers; ++memory_node) {
-      free_lists_.emplace_back(std::make_unique<freelist::FreeList>(
-        block_size_,
-        memory_node,
-        free_list_offsets[memory_node],
-        remote_access_tokens[memory_node]));
+      block_pools_.emplace_back(
+        std::make_unique<BlockPool>(block_size_,
+                                    memory_node,
+                                    free_list_offsets[memory_node],
+                                    remote_access_tokens[memory_node],
+                                    segment_table_tokens[memory_node]));
+    }
+  }
+
+  // inserts are grouped per compute thread if the batch size exceeds one
+  void set_insert_batch_size(u32 insert_batch_size) {
+    insert_batch_size_ = insert_batch_size;
+  }
+
+  // writes are applied by the owner threads of their terms
+  void enable_term_ownership(u32 node_id, u32 num_nodes) {
+    term_owners_.emplace(num_nodes, num_compute_threads_);
+    num_forwarding_threads_ = num_compute_threads_;
+
+    for (u32 id = 0; id < num_compute_threads_; ++id) {
+      forwarded_updates_.push_back(
+        std::make_unique<concurrent_queue<Update>>());
+    }
+
+    print_status("compute node " + std::to_string(node_id) + " owns " +
+                 std::to_string(num_compute_threads_) + " of " +
+                 std::to_string(num_nodes * num_compute_threads_) +
+                 " term partitions");
+  }
+
+  // unbatched inserts of different terms are overlapped if the depth exceeds
+  // one
+  void set_insert_pipeline_depth(u32 insert_pipeline_depth) {
+    insert_pipeline_depth_ = insert_pipeline_depth;
+  }
+
+  // inserts are appended to delta logs and folded into the blocks by the
+  // compaction thread
+  void enable_delta_buffers(u32 capacity,
+                            u32 universe_size,
+                            MemoryRegionTokens& delta_tokens) {
+    delta_buffers_ =
+      std::make_unique<DeltaBuffers>(capacity, universe_size, delta_tokens);
+  }
+
+  // adjacent blocks are merged by the compaction thread if the merged block
+  // is filled at most merge_fill percent, 0 disables merging
+  void set_merge_fill(u32 merge_fill) { merge_fill_ = merge_fill; }
+
+  // the compaction thread runs on a single compute node
+  void set_run_compactor(bool run_compactor) { run_compactor_ = run_compactor; }
+
+  // blocks READ by queries are cached (and validated by READing their
+  // footers), 0 disables caching
+  void set_cache_blocks(u32 cache_blocks) { cache_blocks_ = cache_blocks; }
+
+  // failed CASs of block locks and free list heads back off up to
+  // max_backoff_ns, locks unchanged for lock_lease_us are released (0
+  // disables either)
+  void set_contention(u32 max_backoff_ns, u32 lock_lease_us) {
+    max_backoff_ns_ = max_backoff_ns;
+    lock_lease_us_ = lock_lease_us;
+  }
+
+  // inserts may add terms below max_terms (besides the terms of the meta
+  // files), 0 disables new terms
+  void set_max_terms(u32 max_terms) { max_terms_ = max_terms; }
+
+  // validations of READ blocks are timed (at the cost of two clock reads)
+  void set_time_validation(bool time_validation) {
+    time_validation_ = time_validation;
+  }
+
+  // heads of terms without a partitioned list are published in (and pulled
+  // from) the remote catalog
+  void enable_term_catalog(u32 max_term, MemoryRegionTokens& catalog_tokens) {
+    term_catalog_ = std::make_unique<TermCatalog>(
+      max_term, catalog_tokens, remote_pointers_, block_pools_);
+
+    for (u32 term = 0; term < block_counts_.size(); ++term) {
+      if (block_counts_[term] > 0) {
+        term_catalog_->set_known(term);
+      }
     }
   }
 
   size_t allocate_worker_threads(Context& context,
                                  ClientConnectionManager& cm) {
     size_t read_buffers_size = 0;
+    // the compaction thread has its own QPs and read buffer
+    const u32 num_threads = num_compute_threads_ + (uses_compactor() ? 1 : 0);
+
     // allocate a contiguous buffer for local memory
-    const size_t total_buffer_size = num_compute_threads_ * READ_BUFFER_LENGTH *
-                                     READ_BUFFER_DEPTH * block_size_;
+    const size_t total_buffer_size =
+      num_threads * READ_BUFFER_LENGTH * READ_BUFFER_DEPTH * block_size_;
     local_buffer_.allocate(total_buffer_size);
     local_buffer_.touch_memory();
 
@@ -75,6 +176,48 @@ public:
     // connect queue pairs
     for (auto& compute_thread : compute_threads_) {
       compute_thread->connect_qps(context, cm);
+      compute_thread->time_validation = time_validation_;
+      reclamation_.add_thread(compute_thread.get());
+    }
+
+    if (cache_blocks_ > 0) {
+      block_cache_ = std::make_unique<BlockCache>(cache_blocks_, block_size_);
+      for (auto& compute_thread : compute_threads_) {
+        compute_thread->block_cache = block_cache_.get();
+      }
+    }
+
+    if (uses_compactor()) {
+      compactor_ = std::make_unique<ComputeThread>(num_compute_threads_,
+                                                   max_send_queue_wr_,
+                                                   context,
+                                                   block_size_,
+                                                   local_buffer_);
+      compactor_->connect_qps(context, cm);
+
+      read_buffers_size +=
+        READ_BUFFER_LENGTH * READ_BUFFER_DEPTH *
+        (block_size_ + sizeof(ReadBuffer<true>::BufferBlock));
+    }
+
+    const auto configure_contention = [&](u_ptr<ComputeThread>& thread) {
+      thread->backoff.set_max_ns(max_backoff_ns_);
+      thread->lock_lease.set_lease_us(lock_lease_us_);
+    };
+
+    for (auto& compute_thread : compute_threads_) {
+      configure_contention(compute_thread);
+    }
+    if (compactor_) {
+      configure_contention(compactor_);
+    }
+
+    if (delta_buffers_) {
+      const u32 log_entries = delta_buffers_->get_log_entries();
+      for (auto& compute_thread : compute_threads_) {
+        compute_thread->allocate_delta_buffer(log_entries);
+      }
+      compactor_->allocate_delta_buffer(log_entries);
     }
 
     return read_buffers_size;
@@ -84,6 +227,7 @@ public:
                                              const str& index_directory) {
     u32 universe_size{};
     u64 catalog_size = 0;
+    vec<std::pair<u64, u32>> heads;  // global position, term
 
     for (u32 memory_node = 0; memory_node < num_servers; ++memory_node) {
       const str binary_file = index_directory + name +
@@ -101,8 +245,8 @@ public:
 
       // do this only once
       if (memory_node == 0) {
-        remote_pointers_.resize(universe_size + 1);
-        catalog_size += universe_size * sizeof(RemotePtr);
+        remote_pointers_.resize(std::max(universe_size + 1, max_terms_));
+        catalog_size += remote_pointers_.size() * sizeof(RemotePtr);
       }
 
       for (u32 i = 0; i < num_init_blocks; ++i) {
@@ -120,9 +264,20 @@ public:
 
         r_ptr.memory_node = memory_node;
         r_ptr.offset = offset;
+        heads.emplace_back(
+          global_block_position(memory_node, offset, num_servers), term);
       }
     }
 
+    // tails are learned by the inserts of this compute node
+    tail_hints_ = TailHints(remote_pointers_.size());
+    for (auto& tail_hint : tail_hints_) {
+      tail_hint = RemotePtr::NO_TAIL_HINT;
+    }
+
+    // initial lengths, inserts are not taken into account
+    block_counts_ = estimate_block_counts(heads, universe_size + 1);
+
 #ifdef DEV_DEBUG
     u32 idx = 0;
     for (auto& r_ptr : remote_pointers_) {
@@ -135,114 +290,584 @@ public:
 
   void process_queries(Queue& query_queue,
                        query::Queries& queries,
-                       MemoryRegionTokens& remote_access_tokens,
+                       MemoryRegionTokens&,  // resolved by the block pools
                        Configuration::Operation& operation,
                        u32 thread_id) {
     auto& compute_thread = compute_threads_[thread_id];
-    auto result_handler = [&](u32) { compute_thread->local_num_result++; };
-    auto poll = [&]() { compute_thread->poll_cq_and_handle(); };
+    u64 query_results = 0;  // counted once the query is not restarted
+    const auto result_handler = [&](u32) { query_results++; };
+
+    const auto allocate_block = [&]() {
+      return allocate_remote_block(compute_thread);
+    };
+
+    const auto deallocate_block = [&](RemotePtr r_ptr) {
+      block_pools_[r_ptr.memory_node]->deallocate(
+        static_cast<u64>(r_ptr.offset) * block_size_, compute_thread);
+    };
+
+    // unlinked blocks might still be READ by queries
+    const auto retire_block = [&](RemotePtr r_ptr) {
+      reclamation_.retire(r_ptr, compute_thread);
+    };
+
+    InsertBatcher insert_batcher{insert_batch_size_};
+    const auto flush_inserts = [&]() {
+      insert_batcher.flush([&](u32 term, vec<u32>& ids) {
+        RemotePtr& r_ptr = remote_pointers_[term];
+
+        while (!r_ptr.find_blocks_and_insert(ids,
+                                             0,
+                                             block_pools_,
+                                             compute_thread,
+                                             allocate_block,
+                                             tail_hints_[term])) {
+        }
+      });
+    };
+
+    InsertPipeline insert_pipeline{insert_pipeline_depth_,
+                                   remote_pointers_,
+                                   tail_hints_,
+                                   block_pools_,
+                                   compute_thread,
+                                   allocate_block};
+
+    const auto apply_insert = [&](u32 term, u32 id, u32 col) {
+      resolve_head(term, true, compute_thread);
+
+      // full delta logs fall back to in-place inserts
+      if (delta_buffers_ && delta_buffers_->append(term, id, compute_thread)) {
+        return;
+      }
+
+      if (insert_batch_size_ > 1) {
+        insert_batcher.add(term, id);
+
+        if (insert_batcher.is_full()) {
+          flush_inserts();
+        }
+
+      } else if (insert_pipeline_depth_ > 1) {
+        insert_pipeline.submit(term, id);
+
+      } else {
+        RemotePtr& r_ptr = remote_pointers_[term];
+
+        while (!r_ptr.find_block_and_insert(id,
+                                            col,
+                                            block_pools_,
+                                            compute_thread,
+                                            allocate_block,
+                                            tail_hints_[term])) {
+        }
+      }
+    };
+
+    const auto apply_delete = [&](u32 term, u32 id, u32 col) {
+      lib_assert(!delta_buffers_, "delete queries require in-place updates");
+      if (!resolve_head(term, false, compute_thread)) {
+        return;  // the term has no entries
+      }
+
+      RemotePtr& r_ptr = remote_pointers_[term];
+
+      while (!r_ptr.find_block_and_delete(
+        id, col, block_pools_, compute_thread, retire_block)) {
+      }
+    };
+
+    // writes to terms owned by other threads are forwarded to them
+    const auto is_owned = [&](u32 term) {
+      return !term_owners_ || term_owners_->get_thread(term) == thread_id;
+    };
 
-    const auto allocate_block = [&]() -> RemotePtr {
-      const u32 allocation_node = compute_thread->get_random_memory_node();
-      const u64 next = free_lists_[allocation_node]->allocate(compute_thread);
-      RemotePtr r_ptr{allocation_node, static_cast<u32>(next / block_size_)};
+    const auto apply_forwarded_updates = [&]() {
+      Update update;
 
-      return r_ptr;
+      while (forwarded_updates_[thread_id]->try_dequeue(update)) {
+        if (update.type == QueryType::INSERT) {
+          apply_insert(update.term, update.id, 0);
+        } else {
+          // pending inserts must be applied before
+          flush_inserts();
+          insert_pipeline.drain();
+          apply_delete(update.term, update.id, 0);
+        }
+      }
     };
 
+    if (thread_id == 0 && compactor_ && run_compactor_) {
+      compactor_->start(&DynamicBlockBasedQueryHandler::compact, this);
+    }
+
+    vec<vec<u32>> deltas(delta_buffers_ ? READ_BUFFER_LENGTH : 0);
+
     start_latch_.arrive_and_wait();
     u32 q;  // idx to query
 
     // try pop queue
-    while (query_queue.try_dequeue(q)) {
+    while (query_queue.try_dequeue(q, thread_id)) {
       compute_thread->processed_queries++;
       query::Query& query = queries[q];
 
+      if (term_owners_) {
+        apply_forwarded_updates();
+      }
+
       if (q % std::max<u32>(queries.size() / 10, 1) == 0) {
         std::cerr << "query " << query << std::endl;
       }
 
-      if (query.type == QueryType::INSERT) {
+      // pending inserts must be visible to the thread's subsequent queries
+      if (query.type != QueryType::INSERT && !insert_batcher.is_empty()) {
+        flush_inserts();
+      }
+      if (query.type != QueryType::INSERT) {
+        insert_pipeline.drain();
+      }
+
+      if (query.type == QueryType::INSERT ||
+          query.type == QueryType::DELETE) {
         for (u32 k_idx = 0; k_idx < query.size(); ++k_idx) {
-          bool success;
-          RemotePtr& r_ptr = remote_pointers_[query.keys[k_idx]];
-
-          do {
-            success = r_ptr.find_block_and_insert(query.update_id,
-                                                  k_idx % READ_BUFFER_LENGTH,
-                                                  remote_access_tokens,
-                                                  compute_thread,
-                                                  allocate_block);
-          } while (!success);
+          const u32 term = query.keys[k_idx];
+          const u32 col = k_idx % READ_BUFFER_LENGTH;
+
+          if (!is_owned(term)) {
+            forwarded_updates_[term_owners_->get_thread(term)]->enqueue(
+              {query.type, term, query.update_id});
+            compute_thread->forwarded_updates++;
+
+          } else if (query.type == QueryType::INSERT) {
+            apply_insert(term, query.update_id, col);
+
+          } else {
+            apply_delete(term, query.update_id, col);
+          }
         }
 
       } else if (query.type == QueryType::READ) {
         lib_assert(query.size() <= READ_BUFFER_LENGTH,
                    "query exceeds read buffer size");
 
-        compute_thread->t_read_list->start();
-        for (u32 k_idx = 0; k_idx < query.size(); ++k_idx) {
-          RemotePtr& r_ptr = remote_pointers_[query.keys[k_idx]];
-          MRT& mrt = remote_access_tokens[r_ptr.memory_node];
-
-          // prevent WR overflow
-          while (compute_thread->post_balance == max_send_queue_wr_) {
-            compute_thread->poll_cq_and_handle();
-          }
-
-          r_ptr.READ_block(k_idx, 0, mrt, compute_thread);
+        // an intersection with a term without a head is empty
+        const bool has_heads =
+          std::all_of(query.keys.begin(), query.keys.end(), [&](u32 term) {
+            return resolve_head(term, false, compute_thread);
+          });
+        if (!has_heads) {
+          continue;
         }
-        compute_thread->t_read_list->stop();
-
-        if (operation == Configuration::Operation::intersection) {
-          operations::block_intersection<true>(
-            result_handler,
-            poll,
-            [&](u32 col, u32 next_row, u32 memory_node, u32 offset) {
-              RemotePtr p{memory_node, offset};
-              MRT& m = remote_access_tokens[memory_node];
-
-              // prevent WR overflow
-              while (compute_thread->post_balance == max_send_queue_wr_) {
-                compute_thread->poll_cq_and_handle();
-              }
-
-              p.READ_block(col, next_row, m, compute_thread);
-            },
-            compute_thread->read_buffer,
-            query.size());
 
-        } else {
-          lib_failure("not yet implemented");
+        // a query that READ a freed block is restarted, the blocks it READs
+        // are not freed until it leaves
+        reclamation_.enter(compute_thread);
+        query_results = 0;
+        while (!read_query(
+          query, operation, compute_thread, deltas, result_handler)) {
+          compute_thread->query_restarts++;
+          query_results = 0;
         }
+
+        reclamation_.leave(compute_thread);
+        compute_thread->local_num_result += query_results;
       }
 
-      // flush completion queue
+      // flush completion queue (pipelined inserts stay in flight)
       // we could have terminated earlier but still have READs/WRITEs posted
-      while (compute_thread->post_balance > 0) {
+      while (insert_pipeline.is_empty() && compute_thread->post_balance > 0) {
         compute_thread->poll_cq_and_handle();
       }
     }
 
+    // owners apply forwarded writes until no thread can forward any more
+    if (term_owners_) {
+      --num_forwarding_threads_;
+
+      bool forwarding;
+      do {
+        forwarding = num_forwarding_threads_ > 0;
+        apply_forwarded_updates();
+      } while (forwarding);
+    }
+
+    insert_pipeline.drain();
+    flush_inserts();
+
+    // return the unused blocks of the thread-local caches
+    for (auto& block_pool : block_pools_) {
+      block_pool->release_cached_blocks(compute_thread);
+    }
+
+    for (u64 encoded : compute_thread->split_blocks) {
+      auto [tag, node, offs] = RemotePtr::decode_remote_ptr(encoded);
+      deallocate_block(RemotePtr{node, offs});
+    }
+    compute_thread->split_blocks.clear();
+
     end_latch_.arrive_and_wait();
+
+    // no query of this compute node is running anymore
+    reclamation_.reclaim(compute_thread);
+
+    if (thread_id == 0 && compactor_ && run_compactor_) {
+      compactor_->set_done();
+      compactor_->join();
+    }
+  }
+
+  // ingests the lists with all compute threads (before the queries)
+  void bulk_ingest(const vec<vec<u32>>& lists) {
+    for (auto& t : compute_threads_) {
+      if (t->get_id() != 0) {
+        t->start(
+          &DynamicBlockBasedQueryHandler::ingest_lists, this, std::cref(lists));
+      }
+    }
+
+    ingest_lists(lists, 0);
+
+    for (auto& t : compute_threads_) {
+      if (t->get_id() != 0) {
+        t->join();
+      }
+    }
+  }
+
+  // thread t ingests the lists of the terms t, t + threads, t + 2 * threads...
+  void ingest_lists(const vec<vec<u32>>& lists, u32 thread_id) {
+    auto& compute_thread = compute_threads_[thread_id];
+
+    BulkIngest bulk_ingest{
+      remote_pointers_,
+      tail_hints_,
+      block_pools_,
+      compute_thread,
+      [&]() { return allocate_remote_block(compute_thread); },
+      [&](RemotePtr r_ptr) {
+        block_pools_[r_ptr.memory_node]->deallocate(
+          static_cast<u64>(r_ptr.offset) * block_size_, compute_thread);
+      }};
+
+    for (u32 term = thread_id; term < lists.size();
+         term += num_compute_threads_) {
+      if (!lists[term].empty()) {
+        resolve_head(term, true, compute_thread);
+        bulk_ingest.ingest(term, lists[term]);
+      }
+    }
+  }
+
+  // READs all lists with all compute threads (after the queries), lists
+  // without a head block remain empty
+  vec<vec<u32>> export_lists() {
+    vec<vec<u32>> lists(remote_pointers_.size());
+
+    for (auto& t : compute_threads_) {
+      if (t->get_id() != 0) {
+        t->start(
+          &DynamicBlockBasedQueryHandler::read_lists, this, std::ref(lists));
+      }
+    }
+
+    read_lists(lists, 0);
+
+    for (auto& t : compute_threads_) {
+      if (t->get_id() != 0) {
+        t->join();
+      }
+    }
+
+    return lists;
+  }
+
+  // thread t READs the lists of the terms t, t + threads, t + 2 * threads...
+  void read_lists(vec<vec<u32>>& lists, u32 thread_id) {
+    auto& compute_thread = compute_threads_[thread_id];
+    ListExport list_export{remote_pointers_, block_pools_, compute_thread};
+    vec<u32> deltas;
+
+    for (u32 term = thread_id; term < lists.size();
+         term += num_compute_threads_) {
+      const bool has_head = term_catalog_
+                              ? resolve_head(term, false, compute_thread)
+                              : get_list_length(term) > 0;
+      if (!has_head) {
+        continue;
+      }
+
+      vec<u32>& list = lists[term];
+      list_export.read(term, list);
+
+      // inserts that have not been folded into the blocks
+      if (delta_buffers_) {
+        delta_buffers_->READ(term, 0, compute_thread);
+        while (compute_thread->post_balance > 0) {
+          compute_thread->poll_cq_and_handle();
+        }
+
+        delta_buffers_->collect(0, compute_thread, deltas);
+        const auto middle =
+          list.insert(list.end(), deltas.begin(), deltas.end());
+        std::inplace_merge(list.begin(), middle, list.end());
+        list.erase(std::unique(list.begin(), list.end()), list.end());
+      }
+    }
+  }
+
+  // folds the delta logs into the blocks and merges underfull blocks until
+  // the queries are processed (a last pass follows)
+  void compact(u32) {
+    vec<u32> terms;  // of lists with a head block
+
+    if (merge_fill_ > 0) {
+      block_merger_.emplace(merge_fill_,
+                            compactor_->allocation_block.get_capacity());
+    }
+
+    // with a catalog, the terms are collected before each pass
+    if (block_merger_ && !term_catalog_) {
+      for (u32 term = 0; term < block_counts_.size(); ++term) {
+        if (block_counts_[term] > 0) {
+          terms.push_back(term);
+        }
+      }
+    }
+
+    bool done;
+    do {
+      done = compactor_->is_done();
+
+      if (delta_buffers_) {
+        fold_deltas();
+      }
+
+      if (block_merger_) {
+        // new terms might have been published by any compute node
+        if (term_catalog_) {
+          term_catalog_->pull_heads(compactor_);
+          term_catalog_->collect_terms(terms);
+        }
+
+        // absorbed successors might still be READ by queries that passed
+        // their predecessor before the merge
+
+        block_merger_->merge_lists(
+          terms, remote_pointers_, block_pools_, compactor_, [&](RemotePtr r) {
+            reclamation_.retire(r, compactor_);
+          });
+      }
+
+      if (!done) {
+        std::this_thread::sleep_for(
+          std::chrono::milliseconds(COMPACTION_INTERVAL_MS));
+      }
+    } while (!done);
+
+    for (auto& block_pool : block_pools_) {
+      block_pool->release_cached_blocks(compactor_);
+    }
+
+    // the queries are done
+    reclamation_.reclaim(compactor_);
+  }
+
+  // folds all non-empty delta logs into the blocks
+  void fold_deltas() {
+    delta_buffers_->compact(compactor_, [&](u32 term, vec<u32>& ids) {
+      // the head has been published before the first append
+      resolve_head(term, false, compactor_);
+      RemotePtr& r_ptr = remote_pointers_[term];
+
+      while (!r_ptr.find_blocks_and_insert(
+        ids,
+        0,
+        block_pools_,
+        compactor_,
+        [&]() { return allocate_remote_block(compactor_); },
+        tail_hints_[term])) {
+      }
+    });
   }
 
   ComputeThreads& get_compute_threads() { return compute_threads_; }
+  ComputeThread* get_compactor() { return compactor_.get(); }
+  const std::optional<BlockMerger>& get_block_merger() const {
+    return block_merger_;
+  }
   RemotePointers& get_remote_pointers() { return remote_pointers_; }
+  BlockPools& get_block_pools() { return block_pools_; }
+
+  // in blocks
+  u64 get_list_length(u32 term) const {
+    return term < block_counts_.size() ? block_counts_[term] : 0;
+  }
+
+private:
+  bool uses_compactor() const { return delta_buffers_ || merge_fill_ > 0; }
+
+  // READs the lists of the query and intersects them, returns false if a
+  // block has been freed meanwhile (the results must be discarded)
+  bool read_query(const query::Query& query,
+                  Configuration::Operation operation,
+                  u_ptr<ComputeThread>& compute_thread,
+                  vec<vec<u32>>& deltas,
+                  const func<void(u32)>& result_handler) {
+    auto poll = [&]() { compute_thread->poll_cq_and_handle(); };
+    compute_thread->stale_query = false;
+
+    compute_thread->t_read_list->start();
+    // the logs are READ before the blocks: entries are removed from a log
+    // only after they have been folded into the blocks
+    if (delta_buffers_) {
+      for (u32 k_idx = 0; k_idx < query.size(); ++k_idx) {
+        delta_buffers_->READ(query.keys[k_idx], k_idx, compute_thread);
+      }
+
+      while (compute_thread->post_balance > 0) {
+        compute_thread->poll_cq_and_handle();
+      }
+
+      for (u32 k_idx = 0; k_idx < query.size(); ++k_idx) {
+        delta_buffers_->collect(k_idx, compute_thread, deltas[k_idx]);
+      }
+    }
+
+    for (u32 k_idx = 0; k_idx < query.size(); ++k_idx) {
+      RemotePtr& r_ptr = remote_pointers_[query.keys[k_idx]];
+
+      // prevent WR overflow
+      while (compute_thread->post_balance == max_send_queue_wr_) {
+        compute_thread->poll_cq_and_handle();
+      }
+
+      r_ptr.READ_block_cached(k_idx, 0, block_pools_, compute_thread);
+    }
+    compute_thread->t_read_list->stop();
+
+    // the successor must carry the tag of the pointer in its predecessor
+    // (the current block of the list)
+    const auto post_READ =
+      [&](u32 col, u32 next_row, u32 memory_node, u32 offset) {
+        const u32 row = (next_row + READ_BUFFER_DEPTH - 1) % READ_BUFFER_DEPTH;
+        RemotePtr p{memory_node,
+                    offset,
+                    compute_thread->read_buffer.get_block(col, row)
+                      .get_remote_ptr_tag()};
+
+        // prevent WR overflow
+        while (compute_thread->post_balance == max_send_queue_wr_) {
+          compute_thread->poll_cq_and_handle();
+        }
+
+        p.READ_block_cached(col, next_row, block_pools_, compute_thread);
+      };
+
+    if (operation == Configuration::Operation::intersection &&
+        delta_buffers_) {
+      operations::block_intersection_with_deltas(result_handler,
+                                                 poll,
+                                                 post_READ,
+                                                 compute_thread->read_buffer,
+                                                 deltas,
+                                                 query.size());
+
+    } else if (operation == Configuration::Operation::intersection) {
+      operations::block_intersection<true>(result_handler,
+                                           poll,
+                                           post_READ,
+                                           compute_thread->read_buffer,
+                                           query.size());
+
+    } else {
+      lib_failure("not yet implemented");
+    }
+
+    // a block arriving later is not part of the intersection, but READs of
+    // a restarted query must not arrive in its new blocks
+    const bool stale = compute_thread->stale_query;
+    while (compute_thread->post_balance > 0) {
+      compute_thread->poll_cq_and_handle();
+    }
+
+    return !stale;
+  }
+
+  // returns false if the term has no head block (new terms are assigned one
+  // if create is set), without a catalog all terms are assumed to have one
+  bool resolve_head(u32 term, bool create, u_ptr<ComputeThread>& thread) {
+    if (!term_catalog_) {
+      return true;
+    }
+
+    return term_catalog_->resolve(
+      term,
+      create,
+      thread,
+      [&]() { return allocate_remote_block(thread); },
+      [&](RemotePtr r_ptr) {
+        block_pools_[r_ptr.memory_node]->deallocate(
+          static_cast<u64>(r_ptr.offset) * block_size_, thread);
+      });
+  }
+
+  RemotePtr allocate_remote_block(u_ptr<ComputeThread>& compute_thread) {
+    const u32 allocation_node = compute_thread->get_random_memory_node();
+    const u64 next = block_pools_[allocation_node]->allocate(compute_thread);
+    RemotePtr r_ptr{allocation_node, static_cast<u32>(next / block_size_)};
+
+    return r_ptr;
+  }
 
 private:
   const u32 num_compute_threads_;
   const i32 max_send_queue_wr_;
   const u32 block_size_;
+  u32 insert_batch_size_{1};
+  u32 insert_pipeline_depth_{1};
+
+  // a write forwarded to the owner thread of its term
+  struct Update {
+    QueryType type;
+    u32 term;
+    u32 id;
+  };
+
+  std::optional<query::TermOwners> term_owners_;
+  vec<u_ptr<concurrent_queue<Update>>> forwarded_updates_;  // per thread
+  std::atomic<u32> num_forwarding_threads_{0};
 
   ComputeThreads compute_threads_;
+
+  u_ptr<DeltaBuffers> delta_buffers_;
+  u32 merge_fill_{0};
+  std::optional<BlockMerger> block_merger_;
+
+  u32 cache_blocks_{0};
+  u_ptr<BlockCache> block_cache_;
+
+  u32 max_backoff_ns_{0};
+  u32 lock_lease_us_{0};
+
+  u32 max_terms_{0};
+  u_ptr<TermCatalog> term_catalog_;
+
+  bool time_validation_{false};
+
+  // folds delta logs and merges underfull blocks
+  u_ptr<ComputeThread> compactor_;
+  bool run_compactor_{false};
+
   RemotePointers remote_pointers_;
+  TailHints tail_hints_;  // per term
+  vec<u32> block_counts_;
   HugePage<u32> local_buffer_;
 
   Latch start_latch_{};
   Latch end_latch_{};
 
-  vec<u_ptr<freelist::FreeList>> free_lists_;  // per memory node
+  BlockPools block_pools_;
+  EpochReclamation reclamation_{block_pools_};
 };
 
 }  // namespace inv_index::block_based::dynamic
@@ -1,9 +1,14 @@
 #ifndef INDEX_BLOCK_BASED_DYNAMIC_REMOTE_POINTER_HH
 #define INDEX_BLOCK_BASED_DYNAMIC_REMOTE_POINTER_HH
 
+#include <algorithm>
+#include <atomic>
+#include <iterator>
 #include <library/memory_region.hh>
+#include <optional>
 #include <ostream>
 
+#include "block_pool.hh"
 #include "compute_thread.hh"
 #include "insert.hh"
 
@@ -14,10 +19,26 @@ struct RemotePtr {
   u32 offset{0};  // 32b are sufficient to address the blocks in a memory node
                   // (we assume that the block size is sufficiently large)
                   // offset is just the number of the block (not an address)
+  u16 tag{0};     // of the head block (zero for the partitioned lists)
 
   static inline u32 block_size;
   using BufferBlock = ReadBuffer<true>::BufferBlock;
 
+  // tail hints hold the encoded remote pointer to the last block of a list
+  static constexpr u64 NO_TAIL_HINT = static_cast<u64>(-1);
+
+  // WRITEs cover all cache lines of a block unless a dirty range is given
+  static constexpr u32 ALL_LINES = static_cast<u32>(-1);
+
+  // a locked footer word whose holder is WRITing the block (with leases),
+  // the fill count of a block never reaches its maximum
+  static constexpr u64 COMMITTING =
+    (static_cast<u64>((1u << 15) - 1) << 17) | 1;
+
+  static bool is_committing(u64 word) {
+    return (word & COMMITTING) == COMMITTING;
+  }
+
   // this only works for remote pointers contained in blocks (not in the
   // catalog), because (0, 0) is always the very first block due to the
   // partitioning scheme, so no block can point to a previous block
@@ -43,6 +64,23 @@ struct RemotePtr {
     return d_word;
   }
 
+  // [ p_tag (16) | m_id (10) | offset(38) ] -> tag, m_id, offset
+  static std::tuple<u16, u32, u32> decode_remote_ptr(u64 d_word) {
+    return {d_word >> 48, (d_word << 16) >> (64 - 10), (d_word << 26) >> 26};
+  }
+
+  // token of the memory region (segment) containing the block
+  MRT& get_token(BlockPools& block_pools, u_ptr<ComputeThread>& thread) const {
+    return block_pools[memory_node]->get_token(offset, thread);
+  }
+
+  void READ_block(u32 col,
+                  u32 row,
+                  BlockPools& block_pools,
+                  u_ptr<ComputeThread>& thread) {
+    READ_block(col, row, get_token(block_pools, thread), thread);
+  }
+
   void READ_block(u32 col, u32 row, MRT& mrt, u_ptr<ComputeThread>& thread) {
     auto& block = thread->read_buffer.get_block(col, row);
     const u64 wr_id = encode_64bit(col, row);
@@ -81,50 +119,196 @@ struct RemotePtr {
     // caution: offset * block_size must be u64
   }
 
+  // READs a block of a query, which is dropped (and the query restarted) if
+  // its tag differs from the tag of this pointer, only the footer of a
+  // cached block is READ (and validated by the READ handler), uncached blocks
+  // are READ as a whole and cached once validated
+  void READ_block_cached(u32 col,
+                         u32 row,
+                         BlockPools& block_pools,
+                         u_ptr<ComputeThread>& thread) {
+    auto& block = thread->read_buffer.get_block(col, row);
+    MRT& mrt = get_token(block_pools, thread);
+    const u64 wr_id = encode_64bit(col, row) | WR_READ_QUERY;
+    thread->expected_tags[ComputeThread::get_block_index(col, row)] = tag;
+
+    if (!thread->block_cache ||
+        !thread->block_cache->lookup(memory_node, offset, block.buffer)) {
+      READ_block(block,
+                 thread->block_cache ? wr_id | WR_READ_CACHE : wr_id,
+                 thread->buffer_region.get_lkey(),
+                 mrt,
+                 thread);
+      return;
+    }
+
+    block.ready = false;
+    block.memory_node = memory_node;
+    block.remote_offset = offset;
+    block.mrt = &mrt;
+
+    thread->post_balance++;
+    thread->rdma_reads_in_bytes += sizeof(u64);
+
+    thread->qps[memory_node]->qp->post_send(
+      thread->footer_region.get_address(),
+      sizeof(u64),
+      thread->footer_region.get_lkey(),
+      IBV_WR_RDMA_READ,
+      true,
+      false,
+      mrt.get(),
+      static_cast<u64>(offset + 1) * block_size - sizeof(u64),
+      ComputeThread::get_block_index(col, row) * sizeof(u64),
+      wr_id | WR_READ_FOOTER);
+  }
+
+  // WRITEs the dirty cache lines [first_line, end_line) followed by the last
+  // cache line (holding the footer), by default the whole block is written
+  // (without the last word of the footer if it is swapped by a CAS instead)
   static void WRITE_block(BufferBlock& block,
                           u64 wr_id,
                           u32 lkey,
                           QP& qp,
                           u32 remote_offset,
                           MRT& mrt,
-                          u_ptr<ComputeThread>& thread) {
-    block.increase_cache_line_versions();
+                          u_ptr<ComputeThread>& thread,
+                          u32 first_line = 0,
+                          u32 end_line = ALL_LINES) {
+    const u32 last_line = block.get_num_cache_lines() - 1;
+    end_line = std::min(end_line, last_line);
+    first_line = std::min(first_line, end_line);
+
+    block.version_block(first_line, end_line);
+    block.set_fill_count(block.count_entries());
     block.just_writing = true;
+
+    const u64 remote_address = remote_offset * static_cast<u64>(block_size);
+
+    // the footer must not arrive before the dirty cache lines
+    if (first_line < end_line && end_line < last_line) {
+      const u32 size = (end_line - first_line) * CACHE_LINE_SIZE;
+      thread->rdma_writes_in_bytes += size;
+
+      qp->post_send(block.get_address(),
+                    size,
+                    lkey,
+                    IBV_WR_RDMA_WRITE,
+                    false,
+                    false,
+                    mrt.get(),
+                    remote_address + first_line * CACHE_LINE_SIZE,
+                    first_line * CACHE_LINE_SIZE,
+                    wr_id);
+      first_line = last_line;
+    }
+
+    // dirty cache lines adjacent to the last one are written at once
+    if (first_line == end_line) {
+      first_line = last_line;
+    }
+
+    const u32 size = block_size - first_line * CACHE_LINE_SIZE;
+    thread->rdma_writes_in_bytes += size;
     thread->post_balance++;
 
     qp->post_send(block.get_address(),
-                  block_size,
+                  size,
                   lkey,
                   IBV_WR_RDMA_WRITE,
                   true,
                   false,
                   mrt.get(),
-                  remote_offset * static_cast<u64>(block_size),
-                  0,
+                  remote_address + first_line * CACHE_LINE_SIZE,
+                  first_line * CACHE_LINE_SIZE,
                   wr_id);
   }
 
-  static void WRITE_and_unlock_block(u32 col,
+  // returns false if the lock has been lost (only with leases), i.e., the
+  // operation must be retried
+  static bool WRITE_and_unlock_block(u32 col,
                                      u32 row,
                                      QP& qp,
                                      u32 remote_offset,
                                      MRT& mrt,
-                                     u_ptr<ComputeThread>& thread) {
+                                     u_ptr<ComputeThread>& thread,
+                                     u32 first_line = 0,
+                                     u32 end_line = ALL_LINES) {
     auto& block = thread->read_buffer.get_block(col, row);
-    block.set_unlock();
 
+    return WRITE_and_unlock(block,
+                            block.get_last_word(),
+                            encode_64bit(col, row),
+                            thread->buffer_region.get_lkey(),
+                            qp,
+                            remote_offset,
+                            mrt,
+                            thread,
+                            first_line,
+                            end_line);
+  }
+
+  // without leases, the footer is just WRITTEN (nobody else unlocks the
+  // block), with leases, the holder first swaps its locked word for the
+  // committing word, which waiters do not release, i.e., a holder whose lock
+  // has been released notices it before WRITing anything (a thread that has
+  // locked the same word since then sees the same block, its own swap fails)
+  static bool WRITE_and_unlock(BufferBlock& block,
+                               u64 locked_word,
+                               u64 wr_id,
+                               u32 lkey,
+                               QP& qp,
+                               u32 remote_offset,
+                               MRT& mrt,
+                               u_ptr<ComputeThread>& thread,
+                               u32 first_line = 0,
+                               u32 end_line = ALL_LINES) {
+    auto& lease = thread->lock_lease;
+    lease.release();
+
+    if (lease.is_enabled() && !CAS_footer(locked_word,
+                                          locked_word | COMMITTING,
+                                          qp,
+                                          mrt,
+                                          remote_offset,
+                                          thread)) {
+      thread->lost_locks++;
+      return false;
+    }
+
+    block.set_unlock();
     WRITE_block(block,
-                encode_64bit(col, row),
-                thread->buffer_region.get_lkey(),
+                wr_id,
+                lkey,
                 qp,
                 remote_offset,
                 mrt,
-                thread);
+                thread,
+                first_line,
+                end_line);
+    return true;
+  }
+
+  // returns true if the footer word has been swapped
+  static bool CAS_footer(u64 compare,
+                         u64 swap,
+                         QP& qp,
+                         MRT& mrt,
+                         u32 remote_offset,
+                         u_ptr<ComputeThread>& thread) {
+    thread->post_balance++;
+    thread->post_balance_CAS++;
+    qp->post_CAS(thread->cas_region,
+                 mrt.get(),
+                 static_cast<u64>(remote_offset + 1) * block_size - sizeof(u64),
+                 compare,
+                 swap);
 
-    // I think we can skip this
-    //    while (thread->post_balance > 0) {
-    //      thread->poll_cq_and_handle();
-    //    }
+    while (thread->post_balance_CAS > 0) {
+      thread->poll_cq_and_handle();
+    }
+
+    return thread->cas_buffer == compare;
   }
 
   static bool LOCK_block(BufferBlock& block,
@@ -148,21 +332,143 @@ struct RemotePtr {
     }
 
     if (thread->cas_buffer != compare) {
+      const u64 current = thread->cas_buffer;
+      if ((current & 1) && !is_committing(current) &&
+          thread->lock_lease.is_expired(current)) {
+        release_stale_lock(current, qp, mrt, remote_offset, thread);
+      }
+
+      // waiting would prolong the locks held by the thread
+      thread->lock_retries.add_retry();
+      if (!thread->lock_lease.holds_lock()) {
+        thread->backoff.wait(thread->lock_retries.retries);
+      }
+
       return false;  // failure
     }
 
     // block is locked now
+    thread->lock_retries.add_success();
+    thread->lock_lease.acquire();
     block.set_lock();
     return true;  // success
   }
 
-  template <typename FAllocate, typename FInsert>
+  // unlocks a block whose lease has expired (its holder has not written
+  // the block, otherwise the word would have changed)
+  static void release_stale_lock(u64 locked_word,
+                                 QP& qp,
+                                 MRT& mrt,
+                                 u32 remote_offset,
+                                 u_ptr<ComputeThread>& thread) {
+    if (CAS_footer(locked_word,
+                   locked_word & ~static_cast<u64>(1),
+                   qp,
+                   mrt,
+                   remote_offset,
+                   thread)) {
+      thread->lock_lease.forget();
+      thread->stale_locks_released++;
+    }
+  }
+
+  // posts the CAS increasing the fill count of an unlocked block (the old
+  // word arrives at local_offset of the region), returns the expected word
+  static u64 post_reservation(BufferBlock& block,
+                              QP& qp,
+                              MRT& mrt,
+                              u32 remote_offset,
+                              u_ptr<ComputeThread>& thread,
+                              MemoryRegion& region,
+                              u64 local_offset,
+                              u64 wr_id) {
+    const u64 compare = block.get_last_word();
+    block.set_fill_count(block.count_entries() + 1);
+    const u64 swap = block.get_last_word();
+
+    thread->post_balance++;
+    qp->post_CAS(region,
+                 mrt.get(),
+                 static_cast<u64>(remote_offset + 1) * block_size - sizeof(u64),
+                 compare,
+                 swap,
+                 true,
+                 wr_id,
+                 local_offset);
+
+    return compare;
+  }
+
+  // reserves the next free slot of an unlocked block by increasing its fill
+  // count, concurrent lock and reservation attempts fail on the changed word
+  static bool RESERVE_slot(BufferBlock& block,
+                           QP& qp,
+                           MRT& mrt,
+                           u32 remote_offset,
+                           u_ptr<ComputeThread>& thread) {
+    thread->post_balance_CAS++;
+    const u64 compare = post_reservation(
+      block, qp, mrt, remote_offset, thread, thread->cas_region, 0, 0);
+
+    while (thread->post_balance_CAS > 0) {
+      thread->poll_cq_and_handle();
+    }
+
+    return thread->cas_buffer == compare;
+  }
+
+  // WRITEs a single entry into its reserved slot (a 4B WRITE is atomic)
+  static void WRITE_entry(u32 col,
+                          u32 row,
+                          u32 pos,
+                          QP& qp,
+                          u32 remote_offset,
+                          MRT& mrt,
+                          u_ptr<ComputeThread>& thread) {
+    auto& block = thread->read_buffer.get_block(col, row);
+    block.just_writing = true;
+    thread->post_balance++;
+    thread->rdma_writes_in_bytes += sizeof(u32);
+
+    qp->post_send_inlined(
+      block.buffer + pos,
+      sizeof(u32),
+      IBV_WR_RDMA_WRITE,
+      true,
+      mrt.get(),
+      remote_offset * static_cast<u64>(block_size) + pos * sizeof(u32),
+      0,
+      encode_64bit(col, row));
+  }
+
+  // blocks of splits are allocated before the split block is locked (an
+  // allocation may take long, e.g., while the pool grows), unused blocks are
+  // kept for the next split of the thread
+  template <typename F>
+  static void reserve_split_blocks(u32 num_blocks,
+                                   u_ptr<ComputeThread>& thread,
+                                   F allocate_block) {
+    while (thread->split_blocks.size() < num_blocks) {
+      const RemotePtr r = allocate_block();
+      thread->split_blocks.push_back(
+        encode_remote_ptr(0, r.memory_node, r.offset));
+    }
+  }
+
+  static RemotePtr take_split_block(u_ptr<ComputeThread>& thread) {
+    lib_assert(!thread->split_blocks.empty(), "no split block reserved");
+    auto [tag, node, offs] = decode_remote_ptr(thread->split_blocks.back());
+    thread->split_blocks.pop_back();
+
+    return {node, offs};
+  }
+
+  template <typename F>
   void allocate_and_write_block(BufferBlock& block,
-                                MemoryRegionTokens& remote_access_tokens,
+                                BlockPools& block_pools,
                                 u_ptr<ComputeThread>& thread,
-                                FAllocate allocate_block,
-                                FInsert inserter) {
-    RemotePtr r = allocate_block();
+                                F inserter) {
+    RemotePtr r = take_split_block(thread);
     auto& allocation_block = thread->allocation_block;
 
     while (allocation_block.just_writing) {
@@ -173,7 +479,7 @@ struct RemotePtr {
     r.READ_block(allocation_block,
                  WR_READ_NO_HANDLE,
                  thread->allocation_region.get_lkey(),
-                 remote_access_tokens[r.memory_node],
+                 r.get_token(block_pools, thread),
                  thread);
     while (thread->post_balance > 0) {
       thread->poll_cq_and_handle();
@@ -195,7 +501,7 @@ struct RemotePtr {
                 thread->allocation_region.get_lkey(),
                 thread->qps[r.memory_node]->qp,
                 r.offset,
-                remote_access_tokens[r.memory_node],
+                r.get_token(block_pools, thread),
                 thread);
 
     // wait until done with writing
@@ -204,20 +510,357 @@ struct RemotePtr {
     }
   }
 
+  // the increased block tag invalidates all remote pointers to this block
+  // (writers and queries READing it start over), deallocate_block must defer
+  // its reuse until no query can READ it anymore (see EpochReclamation)
+  template <typename F>
+  static void release_block(BufferBlock& block,
+                            u64 wr_id,
+                            u32 lkey,
+                            RemotePtr r,
+                            BlockPools& block_pools,
+                            u_ptr<ComputeThread>& thread,
+                            F deallocate_block) {
+    const u64 locked_word = block.get_last_word();
+    block.assign_entries({});
+    block.set_block_tag(block.get_block_tag() + 1);
+
+    const bool unlocked = WRITE_and_unlock(block,
+                                           locked_word,
+                                           wr_id,
+                                           lkey,
+                                           thread->qps[r.memory_node]->qp,
+                                           r.offset,
+                                           r.get_token(block_pools, thread),
+                                           thread);
+
+    while (thread->post_balance > 0) {
+      thread->poll_cq_and_handle();
+    }
+
+    // a block whose lock has been lost might still be in use
+    if (unlocked) {
+      deallocate_block(r);
+    }
+  }
+
+  // READs the successor into the allocation block and locks it if both
+  // blocks fit into a single one, returns false otherwise
+  static bool lock_successor_for_merge(BufferBlock& block,
+                                       u32 num_entries,
+                                       u32 max_entries,
+                                       BlockPools& block_pools,
+                                       u_ptr<ComputeThread>& thread) {
+    auto& successor = thread->allocation_block;
+    auto [next_node, next_offs] = block.get_remote_ptr();
+    RemotePtr r{next_node, next_offs};
+
+    while (successor.just_writing) {
+      thread->poll_cq_and_handle();
+    }
+
+    r.READ_block(successor,
+                 WR_READ_NO_HANDLE,
+                 thread->allocation_region.get_lkey(),
+                 r.get_token(block_pools, thread),
+                 thread);
+    while (thread->post_balance > 0) {
+      thread->poll_cq_and_handle();
+    }
+
+    if (successor.is_locked() || !thread->validate(successor) ||
+        successor.get_block_tag() != block.get_remote_ptr_tag()) {
+      return false;
+    }
+
+    vec<u32> entries;
+    successor.collect_entries(entries);
+    if (num_entries + entries.size() > max_entries) {
+      return false;
+    }
+
+    if (!LOCK_block(successor,
+                    thread->qps[r.memory_node]->qp,
+                    r.get_token(block_pools, thread),
+                    r.offset,
+                    thread)) {
+      thread->lock_retries.abandon();
+      thread->locking_failed++;
+      return false;
+    }
+
+    return true;
+  }
+
+  // the successor locked for a merge is unchanged, write its footer back
+  static void unlock_successor(u32 node,
+                               u32 offs,
+                               BlockPools& block_pools,
+                               u_ptr<ComputeThread>& thread) {
+    auto& successor = thread->allocation_block;
+    RemotePtr r{node, offs};
+
+    WRITE_and_unlock(successor,
+                     successor.get_last_word(),
+                     WR_WRITE_ALLOCATION_BLOCK,
+                     thread->allocation_region.get_lkey(),
+                     thread->qps[node]->qp,
+                     offs,
+                     r.get_token(block_pools, thread),
+                     thread,
+                     0,
+                     0);
+    while (thread->post_balance > 0) {
+      thread->poll_cq_and_handle();
+    }
+  }
+
+  // removes the id from the block, empty blocks are unlinked from their
+  // predecessor and underfull blocks absorb their successor
+  template <typename F>
+  static bool delete_from_block(u32 id,
+                                u32 col,
+                                u32 row,
+                                RemotePtr r,
+                                std::optional<RemotePtr> predecessor,
+                                BlockPools& block_pools,
+                                u_ptr<ComputeThread>& thread,
+                                F deallocate_block) {
+    auto& block = thread->read_buffer.get_block(col, row);
+    QP& qp = thread->qps[r.memory_node]->qp;
+    MRT& mrt = r.get_token(block_pools, thread);
+
+    vec<u32> entries;
+    block.collect_entries(entries);
+
+    auto it = std::lower_bound(entries.begin(), entries.end(), id);
+    if (it == entries.end() || *it != id) {
+      return true;  // id does not exist
+    }
+
+    if (!LOCK_block(block, qp, mrt, r.offset, thread)) {
+      thread->locking_failed++;
+      return false;
+    }
+
+    const u32 removed = std::distance(entries.begin(), it);
+    entries.erase(it);
+
+    // case 1: the block is empty, unlink it from its predecessor
+    if (entries.empty() && predecessor.has_value()) {
+      const u32 pred_row = (row + 1) % READ_BUFFER_DEPTH;
+      auto& pred_block = thread->read_buffer.get_block(col, pred_row);
+      QP& pred_qp = thread->qps[predecessor->memory_node]->qp;
+      MRT& pred_mrt = predecessor->get_token(block_pools, thread);
+
+      if (!LOCK_block(
+            pred_block, pred_qp, pred_mrt, predecessor->offset, thread)) {
+        thread->locking_failed++;
+
+        // the block is unchanged, write its footer back to unlock it
+        WRITE_and_unlock_block(col, row, qp, r.offset, mrt, thread, 0, 0);
+        while (thread->post_balance > 0) {
+          thread->poll_cq_and_handle();
+        }
+
+        return false;
+      }
+
+      pred_block.set_raw_remote_ptr(block.get_raw_remote_ptr());
+      if (!WRITE_and_unlock_block(col,
+                                  pred_row,
+                                  pred_qp,
+                                  predecessor->offset,
+                                  pred_mrt,
+                                  thread,
+                                  0,
+                                  0)) {
+        // the block is still linked, write its footer back to unlock it
+        WRITE_and_unlock_block(col, row, qp, r.offset, mrt, thread, 0, 0);
+        while (thread->post_balance > 0) {
+          thread->poll_cq_and_handle();
+        }
+
+        return false;
+      }
+
+      release_block(block,
+                    encode_64bit(col, row),
+                    thread->buffer_region.get_lkey(),
+                    r,
+                    block_pools,
+                    thread,
+                    deallocate_block);
+
+      return true;
+    }
+
+    // case 2: the block is underfull, merge the successor into it
+    // (the head of a list must not become empty if it has a successor)
+    const u32 capacity = block.get_capacity();
+    bool merge = false;
+
+    if (!block.points_to_null() &&
+        (entries.empty() || entries.size() < capacity / 4)) {
+      const u32 max_entries = entries.empty() ? capacity : capacity / 2;
+      merge = lock_successor_for_merge(
+        block, entries.size(), max_entries, block_pools, thread);
+
+      if (!merge && entries.empty()) {
+        // the block is unchanged, write its footer back to unlock it
+        WRITE_and_unlock_block(col, row, qp, r.offset, mrt, thread, 0, 0);
+        while (thread->post_balance > 0) {
+          thread->poll_cq_and_handle();
+        }
+
+        return false;
+      }
+    }
+
+    auto& successor = thread->allocation_block;
+    auto [next_node, next_offs] = block.get_remote_ptr();
+
+    // without merging, only the entries following the removed one move
+    const auto [first_line, end_line] =
+      merge ? std::make_pair(0u, ALL_LINES)
+            : BufferBlock::get_entry_lines(removed, entries.size() + 1);
+
+    if (merge) {
+      successor.collect_entries(entries);
+      block.set_raw_remote_ptr(successor.get_raw_remote_ptr());
+    }
+
+    block.assign_entries(entries);
+    if (!WRITE_and_unlock_block(
+          col, row, qp, r.offset, mrt, thread, first_line, end_line)) {
+      if (merge) {
+        unlock_successor(next_node, next_offs, block_pools, thread);
+      }
+
+      return false;
+    }
+
+    if (merge) {
+      release_block(successor,
+                    WR_WRITE_ALLOCATION_BLOCK,
+                    thread->allocation_region.get_lkey(),
+                    RemotePtr{next_node, next_offs},
+                    block_pools,
+                    thread,
+                    deallocate_block);
+    }
+
+    return true;
+  }
+
+  // merges the successor into the (unlocked) block if the entries of both
+  // fit into max_entries, the emptied successor is released
+  template <typename F>
+  static bool merge_with_successor(u32 col,
+                                   u32 row,
+                                   RemotePtr r,
+                                   u32 max_entries,
+                                   BlockPools& block_pools,
+                                   u_ptr<ComputeThread>& thread,
+                                   F deallocate_block) {
+    auto& block = thread->read_buffer.get_block(col, row);
+    QP& qp = thread->qps[r.memory_node]->qp;
+    MRT& mrt = r.get_token(block_pools, thread);
+
+    vec<u32> entries;
+    block.collect_entries(entries);
+
+    if (!LOCK_block(block, qp, mrt, r.offset, thread)) {
+      thread->lock_retries.abandon();
+      thread->locking_failed++;
+      return false;
+    }
+
+    if (!lock_successor_for_merge(
+          block, entries.size(), max_entries, block_pools, thread)) {
+      // the block is unchanged, write its footer back to unlock it
+      WRITE_and_unlock_block(col, row, qp, r.offset, mrt, thread, 0, 0);
+      while (thread->post_balance > 0) {
+        thread->poll_cq_and_handle();
+      }
+
+      return false;
+    }
+
+    auto& successor = thread->allocation_block;
+    auto [next_node, next_offs] = block.get_remote_ptr();
+
+    // the entries of the successor are appended
+    const u32 num_entries = entries.size();
+    successor.collect_entries(entries);
+    block.set_raw_remote_ptr(successor.get_raw_remote_ptr());
+
+    const auto [first_line, end_line] =
+      BufferBlock::get_entry_lines(num_entries, entries.size());
+    block.assign_entries(entries);
+    if (!WRITE_and_unlock_block(
+          col, row, qp, r.offset, mrt, thread, first_line, end_line)) {
+      unlock_successor(next_node, next_offs, block_pools, thread);
+      return false;
+    }
+
+    release_block(successor,
+                  WR_WRITE_ALLOCATION_BLOCK,
+                  thread->allocation_region.get_lkey(),
+                  RemotePtr{next_node, next_offs},
+                  block_pools,
+                  thread,
+                  deallocate_block);
+
+    return true;
+  }
+
+  // position following the last entry (we cannot overwrite a cache line
+  // version)
+  static u32 get_append_pos(const BufferBlock& block) {
+    return BufferBlock::get_entry_position(block.count_entries());
+  }
+
+  // the block has been the tail, now it or its new successor is the tail
+  static void set_tail_hint(std::atomic<u64>& tail_hint,
+                            const BufferBlock& block,
+                            u32 node,
+                            u32 offs) {
+    tail_hint = block.points_to_null()
+                  ? encode_remote_ptr(block.get_block_tag(), node, offs)
+                  : block.get_raw_remote_ptr();
+  }
+
+  static void drop_tail_hint(std::atomic<u64>& tail_hint,
+                             u64 hint,
+                             u_ptr<ComputeThread>& thread) {
+    tail_hint.compare_exchange_strong(hint, NO_TAIL_HINT);
+    thread->tail_hint_misses++;
+  }
+
   // TODO: move to a separate class?
   template <typename F>
   bool find_block_and_insert(u32 id,
                              u32 col,
-                             MemoryRegionTokens& remote_access_tokens,
+                             BlockPools& block_pools,
                              u_ptr<ComputeThread>& thread,
-                             F allocate_block) {
-    u32 row = 0;
-    READ_block(col, row, remote_access_tokens[memory_node], thread);
-
-    u16 expected_tag = 0;  // first block has always a zero tag
+                             F allocate_block,
+                             std::atomic<u64>& tail_hint) {
+    u16 expected_tag = tag;  // the tag of the head block
     u32 node = memory_node;
     u32 offs = offset;
 
+    // appends can start at the hinted tail instead of the head
+    const u64 hint = tail_hint;
+    bool from_tail = hint != NO_TAIL_HINT;
+    if (from_tail) {
+      std::tie(expected_tag, node, offs) = decode_remote_ptr(hint);
+    }
+
+    u32 row = 0;
+    RemotePtr start{node, offs};
+    start.READ_block(col, row, block_pools, thread);
+
     while (true) {
       while (thread->post_balance > 0) {
         thread->poll_cq_and_handle();
@@ -228,7 +871,7 @@ struct RemotePtr {
       if (!block.is_valid) {
         // optimistic read failed, re-start READing the current block
         RemotePtr p{node, offs};
-        p.READ_block(col, row, remote_access_tokens[node], thread);
+        p.READ_block(col, row, block_pools, thread);
         thread->block_repeated_reads++;
         thread->read_failed++;
 
@@ -238,10 +881,26 @@ struct RemotePtr {
       // happens if the block has been re-used meanwhile (invalid r_pointer)
       // we must restart the whole operation (re-start READing the list)
       if (block.get_block_tag() != expected_tag) {
-        thread->list_repeated_reads++;
+        if (from_tail) {
+          drop_tail_hint(tail_hint, hint, thread);
+        } else {
+          thread->list_repeated_reads++;
+        }
+
         return false;
       }
 
+      // the id may belong to a previous block, start at the head instead
+      if (from_tail) {
+        if (!block.is_empty() && id <= std::get<1>(block.get_min_max())) {
+          drop_tail_hint(tail_hint, hint, thread);
+          return false;
+        }
+
+        thread->tail_hint_hits++;
+        from_tail = false;
+      }
+
       expected_tag = block.get_remote_ptr_tag();
       auto [next_node, next_offs] = block.get_remote_ptr();
 
@@ -249,67 +908,97 @@ struct RemotePtr {
       if (!block.points_to_null()) {
         RemotePtr p{next_node, next_offs};
         u32 next_row = (row + 1) % READ_BUFFER_DEPTH;
-        p.READ_block(col, next_row, remote_access_tokens[next_node], thread);
+        p.READ_block(col, next_row, block_pools, thread);
       }
 
-      auto [min, max, max_pos] = block.get_min_max();
+      // only the very last block of a list can be empty (all ids deleted)
+      const bool empty = block.is_empty();
+      auto [min, max, max_pos] =
+        empty ? std::make_tuple(static_cast<u32>(-1), 0u, 0u)
+              : block.get_min_max();
 
-      // we cannot overwrite a cache line version
-      const u32 insert_pos =
-        ((max_pos + 1) % (CACHE_LINE_SIZE / sizeof(u32)) == 0) ? max_pos + 2
-                                                               : max_pos + 1;
+      const u32 insert_pos = get_append_pos(block);
 
       QP& qp = thread->qps[node]->qp;
-      MRT& mrt = remote_access_tokens[node];
+      MRT& mrt = block_pools[node]->get_token(offs, thread);
 
-      if (max < id) {
+      if (empty || max < id) {
         if (block.points_to_null()) {
+          // case 1: block is not full: reserve the next slot (without
+          //         locking the block) and just WRITE the item into it
+          if (!block.is_full()) {
+            if (!RESERVE_slot(block, qp, mrt, offs, thread)) {
+              // reservation failed, we must reREAD the block
+              RemotePtr p{node, offs};
+              p.READ_block(col, row, block_pools, thread);
+              thread->block_repeated_reads++;
+              thread->reservation_failed++;
+
+              continue;
+            }
+
+            block.buffer[insert_pos] = id;
+            WRITE_entry(col, row, insert_pos, qp, offs, mrt, thread);
+            thread->slot_reservations++;
+
+            set_tail_hint(tail_hint, block, node, offs);
+            break;  // end of loop, we are done
+          }
+
+          reserve_split_blocks(1, thread, allocate_block);
           if (!LOCK_block(block, qp, mrt, offs, thread)) {
             // locking failed, we must reREAD the block
             RemotePtr p{node, offs};
-            p.READ_block(col, row, remote_access_tokens[node], thread);
+            p.READ_block(col, row, block_pools, thread);
             thread->block_repeated_reads++;
             thread->locking_failed++;
 
             continue;
           }
 
-          // case 1: block is full: allocate new block, divide items among the
+          // case 2: block is full: allocate new block, divide items among the
           //         blocks, and append item to the newly allocated block
-          if (block.is_full()) {
-            const auto inserter =
-              [&](u32, u32 free_pos, u32* allocation_block_buffer) {
-                allocation_block_buffer[free_pos] = id;
-              };
+          const auto inserter =
+            [&](u32, u32 free_pos, u32* allocation_block_buffer) {
+              allocation_block_buffer[free_pos] = id;
+            };
 
-            allocate_and_write_block(
-              block, remote_access_tokens, thread, allocate_block, inserter);
+          allocate_and_write_block(block, block_pools, thread, inserter);
 
-            // now we can write and unlock the initial block
-            WRITE_and_unlock_block(col, row, qp, offs, mrt, thread);
+          // now we can write and unlock the initial block
+          if (!WRITE_and_unlock_block(col, row, qp, offs, mrt, thread)) {
+            // the lock has been lost, the new block is not reachable
+            thread->split_blocks.push_back(block.get_raw_remote_ptr());
+            RemotePtr p{node, offs};
+            p.READ_block(col, row, block_pools, thread);
+            thread->block_repeated_reads++;
 
-            // case 2: block is not full: just append item to then end
-          } else {
-            block.buffer[insert_pos] = id;
-            WRITE_and_unlock_block(col, row, qp, offs, mrt, thread);
+            continue;
           }
 
+          set_tail_hint(tail_hint, block, node, offs);
           break;  // end of loop, we are done
         }
         // if max < id and block is not null, we move on
 
         // value is in between
       } else {
+        if (block.is_full()) {
+          reserve_split_blocks(1, thread, allocate_block);
+        }
+
         if (!LOCK_block(block, qp, mrt, offs, thread)) {
           // locking failed, we must reREAD the block
           RemotePtr p{node, offs};
-          p.READ_block(col, row, remote_access_tokens[node], thread);
+          p.READ_block(col, row, block_pools, thread);
           thread->block_repeated_reads++;
           thread->locking_failed++;
 
           continue;
         }
 
+        const bool tail = block.points_to_null();
+
         // case 3: block is full: allocate new block, divide items among the
         //         blocks, and insert the item ordered in one of the blocks
         if (block.is_full()) {
@@ -317,7 +1006,7 @@ struct RemotePtr {
                                     u32 b2_free_pos,
                                     u32* allocation_block_buffer) {
             // insert into first block
-            if (id < allocation_block_buffer[1]) {
+            if (id < allocation_block_buffer[BufferBlock::first_position]) {
               ordered_insert(block.buffer, id, b1_free_pos, block_size);
 
               // insert into second block
@@ -327,16 +1016,43 @@ struct RemotePtr {
             }
           };
 
-          allocate_and_write_block(
-            block, remote_access_tokens, thread, allocate_block, inserter);
+          allocate_and_write_block(block, block_pools, thread, inserter);
 
           // now we can write and unlock the initial block
-          WRITE_and_unlock_block(col, row, qp, offs, mrt, thread);
+          if (!WRITE_and_unlock_block(col, row, qp, offs, mrt, thread)) {
+            // the lock has been lost, the new block is not reachable
+            thread->split_blocks.push_back(block.get_raw_remote_ptr());
+            RemotePtr p{node, offs};
+            p.READ_block(col, row, block_pools, thread);
+            thread->block_repeated_reads++;
+
+            continue;
+          }
 
         } else {
-          // case 4: block is not full: just insert the item ordered
-          ordered_insert(block.buffer, id, insert_pos, block_size);
-          WRITE_and_unlock_block(col, row, qp, offs, mrt, thread);
+          // case 4: block is not full: just insert the item ordered and
+          //         WRITE the shifted cache lines
+          const u32 pos =
+            ordered_insert(block.buffer, id, insert_pos, block_size);
+          if (!WRITE_and_unlock_block(col,
+                                      row,
+                                      qp,
+                                      offs,
+                                      mrt,
+                                      thread,
+                                      pos / CACHE_LINE_ITEMS,
+                                      insert_pos / CACHE_LINE_ITEMS + 1)) {
+            // the lock has been lost, we must reREAD the block
+            RemotePtr p{node, offs};
+            p.READ_block(col, row, block_pools, thread);
+            thread->block_repeated_reads++;
+
+            continue;
+          }
+        }
+
+        if (tail) {
+          set_tail_hint(tail_hint, block, node, offs);
         }
 
         break;  // end of loop, we are done
@@ -347,9 +1063,330 @@ struct RemotePtr {
       row = (row + 1) % READ_BUFFER_DEPTH;
     }
 
+    thread->insert_commits++;
     return true;
   }
 
+  // writes the chunks into reserved split blocks (last to first s.t. every
+  // block is complete before it becomes reachable), returns the encoded
+  // remote pointers to the written blocks in list order
+  static vec<u64> allocate_and_write_blocks(const vec<vec<u32>>& chunks,
+                                            u64 raw_successor,
+                                            BlockPools& block_pools,
+                                            u_ptr<ComputeThread>& thread) {
+    auto& allocation_block = thread->allocation_block;
+    const u32 lkey = thread->allocation_region.get_lkey();
+    vec<u64> written(chunks.size());
+    u64 next = raw_successor;
+
+    for (u32 c = chunks.size(); c-- > 0;) {
+      RemotePtr r = take_split_block(thread);
+
+      while (allocation_block.just_writing) {
+        thread->poll_cq_and_handle();
+      }
+
+      // read block (we must keep the block tag to detect ABA issues)
+      r.READ_block(allocation_block,
+                   WR_READ_NO_HANDLE,
+                   lkey,
+                   r.get_token(block_pools, thread),
+                   thread);
+      while (thread->post_balance > 0) {
+        thread->poll_cq_and_handle();
+      }
+
+      allocation_block.assign_entries(chunks[c]);
+      allocation_block.set_raw_remote_ptr(next);
+
+      WRITE_block(allocation_block,
+                  WR_WRITE_ALLOCATION_BLOCK,
+                  lkey,
+                  thread->qps[r.memory_node]->qp,
+                  r.offset,
+                  r.get_token(block_pools, thread),
+                  thread);
+      while (thread->post_balance > 0) {
+        thread->poll_cq_and_handle();
+      }
+
+      next = encode_remote_ptr(
+        allocation_block.get_block_tag(), r.memory_node, r.offset);
+      written[c] = next;
+    }
+
+    return written;
+  }
+
+  // inserts the ordered (and unique) ids, all ids that belong to the same
+  // block are merged into it with a single lock/WRITE cycle (splitting the
+  // block if needed), inserted ids are removed from the vector
+  template <typename F>
+  bool find_blocks_and_insert(vec<u32>& ids,
+                              u32 col,
+                              BlockPools& block_pools,
+                              u_ptr<ComputeThread>& thread,
+                              F allocate_block,
+                              std::atomic<u64>& tail_hint) {
+    u16 expected_tag = tag;  // the tag of the head block
+    u32 node = memory_node;
+    u32 offs = offset;
+
+    // appends can start at the hinted tail instead of the head
+    const u64 hint = tail_hint;
+    bool from_tail = hint != NO_TAIL_HINT;
+    if (from_tail) {
+      std::tie(expected_tag, node, offs) = decode_remote_ptr(hint);
+    }
+
+    // no READ-ahead: a written block must not be overwritten by a READ
+    u32 row = 0;
+    RemotePtr start{node, offs};
+    start.READ_block(col, row, block_pools, thread);
+
+    vec<u32> entries;
+    vec<u32> merged;
+    vec<u64> written;  // blocks of a split
+
+    while (true) {
+      while (thread->post_balance > 0) {
+        thread->poll_cq_and_handle();
+      }
+
+      auto& block = thread->read_buffer.get_block(col, row);
+
+      if (!block.is_valid) {
+        // optimistic read failed, re-start READing the current block
+        RemotePtr p{node, offs};
+        p.READ_block(col, row, block_pools, thread);
+        thread->block_repeated_reads++;
+        thread->read_failed++;
+
+        continue;
+      }
+
+      // block has been re-used meanwhile, re-start READing the list
+      if (block.get_block_tag() != expected_tag) {
+        if (from_tail) {
+          drop_tail_hint(tail_hint, hint, thread);
+        } else {
+          thread->list_repeated_reads++;
+        }
+
+        return false;
+      }
+
+      // some ids may belong to a previous block, start at the head instead
+      if (from_tail) {
+        if (!block.is_empty() &&
+            ids.front() <= std::get<1>(block.get_min_max())) {
+          drop_tail_hint(tail_hint, hint, thread);
+          return false;
+        }
+
+        thread->tail_hint_hits++;
+        from_tail = false;
+      }
+
+      // ids up to the maximum belong to this block (all ids to the last one)
+      auto end = ids.begin();
+      if (block.points_to_null()) {
+        end = ids.end();
+      } else if (!block.is_empty()) {
+        end = std::upper_bound(
+          ids.begin(), ids.end(), std::get<1>(block.get_min_max()));
+      }
+
+      const u16 next_tag = block.get_remote_ptr_tag();
+      auto [next_node, next_offs] = block.get_remote_ptr();
+
+      if (end != ids.begin()) {
+        QP& qp = thread->qps[node]->qp;
+        MRT& mrt = block_pools[node]->get_token(offs, thread);
+
+        // the locked block equals the READ one (its footer is unchanged)
+        entries.clear();
+        merged.clear();
+        block.collect_entries(entries);
+        std::set_union(entries.begin(),
+                       entries.end(),
+                       ids.begin(),
+                       end,
+                       std::back_inserter(merged));
+
+        const bool tail = block.points_to_null();
+        const u32 capacity = block.get_capacity();
+        const u32 num_blocks =
+          merged.size() <= capacity ? 1 : merged.size() / capacity + 1;
+        reserve_split_blocks(num_blocks - 1, thread, allocate_block);
+
+        if (!LOCK_block(block, qp, mrt, offs, thread)) {
+          // locking failed, we must reREAD the block
+          RemotePtr p{node, offs};
+          p.READ_block(col, row, block_pools, thread);
+          thread->block_repeated_reads++;
+          thread->locking_failed++;
+
+          continue;
+        }
+
+        // entries before the first inserted id do not move (unless split)
+        const u32 first_changed =
+          std::distance(merged.begin(),
+                        std::mismatch(entries.begin(),
+                                      entries.end(),
+                                      merged.begin())
+                          .second);
+        const auto [first_line, end_line] =
+          merged.size() <= capacity
+            ? BufferBlock::get_entry_lines(first_changed, merged.size())
+            : std::make_pair(0u, ALL_LINES);
+
+        written.clear();
+        if (merged.size() <= capacity) {
+          block.assign_entries(merged);
+
+        } else {
+          // divide the entries evenly, the first chunk stays in the block
+          vec<vec<u32>> chunks;
+
+          for (u32 b = 1; b < num_blocks; ++b) {
+            chunks.emplace_back(merged.begin() + b * merged.size() / num_blocks,
+                                merged.begin() +
+                                  (b + 1) * merged.size() / num_blocks);
+          }
+
+          written = allocate_and_write_blocks(
+            chunks, block.get_raw_remote_ptr(), block_pools, thread);
+
+          merged.resize(merged.size() / num_blocks);
+          block.assign_entries(merged);
+          block.set_raw_remote_ptr(written.front());
+        }
+
+        if (!WRITE_and_unlock_block(
+              col, row, qp, offs, mrt, thread, first_line, end_line)) {
+          // the lock has been lost, the new blocks are not reachable
+          thread->split_blocks.insert(
+            thread->split_blocks.end(), written.begin(), written.end());
+          RemotePtr p{node, offs};
+          p.READ_block(col, row, block_pools, thread);
+          thread->block_repeated_reads++;
+
+          continue;
+        }
+
+        if (tail) {
+          if (written.empty()) {
+            set_tail_hint(tail_hint, block, node, offs);
+          } else {
+            tail_hint = written.back();
+          }
+        }
+
+        thread->insert_commits++;
+        ids.erase(ids.begin(), end);
+
+        while (thread->post_balance > 0) {
+          thread->poll_cq_and_handle();
+        }
+      }
+
+      if (ids.empty()) {
+        return true;
+      }
+
+      // the remaining ids belong to the (previous) successor
+      expected_tag = next_tag;
+      node = next_node;
+      offs = next_offs;
+      row = (row + 1) % READ_BUFFER_DEPTH;
+
+      RemotePtr p{node, offs};
+      p.READ_block(col, row, block_pools, thread);
+    }
+  }
+
+  template <typename F>
+  bool find_block_and_delete(u32 id,
+                             u32 col,
+                             BlockPools& block_pools,
+                             u_ptr<ComputeThread>& thread,
+                             F deallocate_block) {
+    // no READ-ahead: the predecessor must stay in the other row
+    u32 row = 0;
+    READ_block(col, row, block_pools, thread);
+
+    u16 expected_tag = tag;  // the tag of the head block
+    u32 node = memory_node;
+    u32 offs = offset;
+    std::optional<RemotePtr> predecessor;
+
+    while (true) {
+      while (thread->post_balance > 0) {
+        thread->poll_cq_and_handle();
+      }
+
+      auto& block = thread->read_buffer.get_block(col, row);
+
+      if (!block.is_valid) {
+        // optimistic read failed, re-start READing the current block
+        RemotePtr p{node, offs};
+        p.READ_block(col, row, block_pools, thread);
+        thread->block_repeated_reads++;
+        thread->read_failed++;
+
+        continue;
+      }
+
+      // block has been re-used meanwhile, re-start READing the list
+      if (block.get_block_tag() != expected_tag) {
+        thread->list_repeated_reads++;
+        return false;
+      }
+
+      if (!block.is_empty()) {
+        auto [min, max, max_pos] = block.get_min_max();
+
+        // the id can only be in this block
+        if (id <= max) {
+          if (id < min) {
+            return true;  // id does not exist
+          }
+
+          const bool success = delete_from_block(id,
+                                                 col,
+                                                 row,
+                                                 RemotePtr{node, offs},
+                                                 predecessor,
+                                                 block_pools,
+                                                 thread,
+                                                 deallocate_block);
+          if (!success) {
+            thread->list_repeated_reads++;
+          }
+
+          return success;
+        }
+      }
+
+      if (block.points_to_null()) {
+        return true;  // id does not exist
+      }
+
+      expected_tag = block.get_remote_ptr_tag();
+      predecessor = RemotePtr{node, offs};
+
+      auto [next_node, next_offs] = block.get_remote_ptr();
+      node = next_node;
+      offs = next_offs;
+      row = (row + 1) % READ_BUFFER_DEPTH;
+
+      RemotePtr p{node, offs};
+      p.READ_block(col, row, block_pools, thread);
+    }
+  }
+
   friend std::ostream& operator<<(std::ostream& os, const RemotePtr& r) {
     os << "[node: " << r.memory_node << ", offset: " << r.offset << "]";
 
@@ -362,6 +1399,7 @@ struct RemotePtr {
 };
 
 using RemotePointers = vec<RemotePtr>;
+using TailHints = vec<std::atomic<u64>>;
 
 }  // namespace inv_index::block_based::dynamic
 
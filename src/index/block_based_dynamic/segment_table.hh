@@ -0,0 +1,41 @@
+#ifndef INDEX_BLOCK_BASED_DYNAMIC_SEGMENT_TABLE_HH
+#define INDEX_BLOCK_BASED_DYNAMIC_SEGMENT_TABLE_HH
+
+#include <library/memory_region.hh>
+#include <library/types.hh>
+
+#include "index/constants.hh"
+
+namespace inv_index::block_based::dynamic {
+
+// contiguous range of blocks registered as its own memory region:
+// blocks | heads | block-nexts
+// block numbers are global per memory node and the token is shifted s.t.
+// block * block_size remains a valid remote offset for every segment
+struct Segment {
+  u64 first_block{};
+  u64 num_blocks{};
+  MemoryRegionToken token{};
+
+  // the free list is located (in blocks) right after the last block
+  u64 get_free_list_offset() const { return first_block + num_blocks; }
+};
+
+// remotely readable table of the block pool segments of a memory node
+struct SegmentTable {
+  u64 num_segments{};
+  Segment segments[MAX_SEGMENTS];
+};
+
+enum class ControlType : u32 { GROW };
+
+// sent by compute threads to a memory node, which replies with the number of
+// segments after handling the message
+struct ControlMessage {
+  ControlType type{};
+  u32 known_segments{};
+};
+
+}  // namespace inv_index::block_based::dynamic
+
+#endif  // INDEX_BLOCK_BASED_DYNAMIC_SEGMENT_TABLE_HH
@@ -0,0 +1,91 @@
+#ifndef INDEX_BLOCK_BASED_DYNAMIC_SNAPSHOT_HH
+#define INDEX_BLOCK_BASED_DYNAMIC_SNAPSHOT_HH
+
+#include <cstdio>
+#include <library/types.hh>
+#include <library/utils.hh>
+
+#include "index/constants.hh"
+#include "index/file_io.hh"
+
+namespace inv_index::block_based::dynamic {
+
+// snapshot of a memory node: header | segments | delta logs | term catalog,
+// every part starts at an aligned offset s.t. it is transferred with O_DIRECT
+struct SnapshotHeader {
+  static constexpr u64 MAGIC = 0x544f485350414e53;  // "SNAPSHOT"
+
+  u64 magic{MAGIC};
+  u64 block_size{};
+  u64 index_size{};  // of the index file the snapshot originates from
+  u64 num_segments{};
+  u64 first_blocks[MAX_SEGMENTS]{};
+  u64 num_blocks[MAX_SEGMENTS]{};
+  u64 delta_size{};    // 0 without delta logs
+  u64 catalog_size{};  // 0 without a term catalog
+};
+
+// the parts are written and read in the same order, a snapshot is written
+// to a temporary file that replaces the previous snapshot once it is durable
+class Snapshot {
+public:
+  Snapshot(const str& path,
+           bool write,
+           u32 num_streams,
+           const vec<u32>& stream_cores)
+      : path_(path),
+        file_(write ? path + ".tmp" : path, write, num_streams, stream_cores) {
+    if (!write) {
+      file_.read(&header, sizeof(SnapshotHeader), 0);
+      lib_assert(header.magic == SnapshotHeader::MAGIC,
+                 "\"" + path + "\" is not a snapshot");
+    }
+  }
+
+  static str get_path(const str& snapshot_dir, const str& index_file) {
+    str name = index_file.substr(index_file.find_last_of('/') + 1);
+    name = name.substr(0, name.find_last_of('.'));
+
+    return snapshot_dir + "/" + name + ".snapshot";
+  }
+
+  void write_part(const void* data, size_t size) {
+    file_.write(data, size, offset_);
+    next_part(size);
+  }
+
+  void read_part(void* data, size_t size) {
+    file_.read(data, size, offset_);
+    next_part(size);
+  }
+
+  // writes the header and replaces the previous snapshot
+  void commit() {
+    file_.write(&header, sizeof(SnapshotHeader), 0);
+    file_.sync();
+    lib_assert(std::rename((path_ + ".tmp").c_str(), path_.c_str()) == 0,
+               "cannot replace snapshot \"" + path_ + "\"");
+  }
+
+  u64 get_transferred_bytes() const { return transferred_bytes_; }
+  bool is_direct() const { return file_.is_direct(); }
+
+private:
+  void next_part(size_t size) {
+    offset_ = File::align(offset_ + size);
+    transferred_bytes_ += size;
+  }
+
+public:
+  SnapshotHeader header{};
+
+private:
+  const str path_;
+  File file_;
+  u64 offset_{File::align(sizeof(SnapshotHeader))};
+  u64 transferred_bytes_{0};
+};
+
+}  // namespace inv_index::block_based::dynamic
+
+#endif  // INDEX_BLOCK_BASED_DYNAMIC_SNAPSHOT_HH
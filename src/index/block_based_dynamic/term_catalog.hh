@@ -0,0 +1,246 @@
+#ifndef INDEX_BLOCK_BASED_DYNAMIC_TERM_CATALOG_HH
+#define INDEX_BLOCK_BASED_DYNAMIC_TERM_CATALOG_HH
+
+#include <algorithm>
+#include <atomic>
+#include <library/memory_region.hh>
+#include <library/types.hh>
+#include <mutex>
+
+#include "block_pool.hh"
+#include "compute_thread.hh"
+#include "remote_pointer.hh"
+
+namespace inv_index::block_based::dynamic {
+
+// heads of terms without a list in the meta files are allocated on demand and
+// published in a remote catalog (term t is hosted by memory node
+// t % num_servers at index t / num_servers): an entry is zero or the encoded
+// remote pointer to the head block (including its tag), the first insert of
+// a term CASes its entry, all other compute threads pull it on a miss
+class TermCatalog {
+public:
+  TermCatalog(u32 max_term,
+              MemoryRegionTokens& catalog_tokens,
+              RemotePointers& remote_pointers,
+              BlockPools& block_pools)
+      : max_term_(max_term),
+        num_servers_(catalog_tokens.size()),
+        catalog_tokens_(catalog_tokens),
+        remote_pointers_(remote_pointers),
+        block_pools_(block_pools),
+        known_(std::make_unique<std::atomic<bool>[]>(max_term + 1)) {
+    for (u32 term = 0; term <= max_term; ++term) {
+      known_[term] = false;
+    }
+  }
+
+  // entries hosted by each of num_servers memory nodes
+  static u32 get_num_entries(u32 max_term, u32 num_servers) {
+    return (max_term + num_servers) / num_servers;
+  }
+
+  // the head of a partitioned list is known from the meta files
+  void set_known(u32 term) { known_[term] = true; }
+
+  // assigns the remote pointer of the term once its head is known, returns
+  // false if the term has no head (and none is created)
+  template <typename FAllocate, typename FDeallocate>
+  bool resolve(u32 term,
+               bool create,
+               u_ptr<ComputeThread>& thread,
+               FAllocate allocate_block,
+               FDeallocate deallocate_block) {
+    if (known_[term].load(std::memory_order_acquire)) {
+      return true;
+    }
+
+    u64 entry = READ_entry(term, thread);
+    if (entry == 0) {
+      if (!create) {
+        return false;
+      }
+
+      entry = publish_head(term, thread, allocate_block, deallocate_block);
+    } else {
+      thread->catalog_pulls++;
+    }
+
+    assign(term, entry);
+    return true;
+  }
+
+  // assigns the heads published since the last pull (e.g., by other compute
+  // nodes), READs the entries of each memory node in chunks of a block
+  void pull_heads(u_ptr<ComputeThread>& thread) {
+    auto& block = thread->read_buffer.get_block(0, 0);
+    while (block.just_writing) {
+      thread->poll_cq_and_handle();
+    }
+
+    const u32 num_entries = get_num_entries(max_term_, num_servers_);
+    const u32 chunk_entries = RemotePtr::block_size / sizeof(u64);
+    const u64* entries = reinterpret_cast<const u64*>(block.buffer);
+
+    for (u32 node = 0; node < num_servers_; ++node) {
+      for (u32 first = 0; first < num_entries; first += chunk_entries) {
+        const u32 count = std::min(chunk_entries, num_entries - first);
+        thread->post_balance++;
+        thread->rdma_reads_in_bytes += count * sizeof(u64);
+
+        thread->qps[node]->qp->post_send(block.get_address(),
+                                         count * sizeof(u64),
+                                         thread->buffer_region.get_lkey(),
+                                         IBV_WR_RDMA_READ,
+                                         true,
+                                         false,
+                                         catalog_tokens_[node].get(),
+                                         static_cast<u64>(first) * sizeof(u64),
+                                         0,
+                                         WR_READ_NO_HANDLE);
+
+        while (thread->post_balance > 0) {
+          thread->poll_cq_and_handle();
+        }
+
+        for (u32 i = 0; i < count; ++i) {
+          const u64 term = static_cast<u64>(first + i) * num_servers_ + node;
+          if (term <= max_term_ && entries[i] != 0 &&
+              !known_[term].load(std::memory_order_acquire)) {
+            assign(term, entries[i]);
+            thread->catalog_pulls++;
+          }
+        }
+      }
+    }
+  }
+
+  // terms whose head is known
+  void collect_terms(vec<u32>& terms) const {
+    terms.clear();
+    for (u32 term = 0; term <= max_term_; ++term) {
+      if (known_[term].load(std::memory_order_acquire)) {
+        terms.push_back(term);
+      }
+    }
+  }
+
+private:
+  void assign(u32 term, u64 entry) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (!known_[term].load(std::memory_order_relaxed)) {
+      const auto [tag, node, offs] = RemotePtr::decode_remote_ptr(entry);
+      remote_pointers_[term] = RemotePtr{node, offs, tag};
+      known_[term].store(true, std::memory_order_release);
+    }
+  }
+
+  u64 get_entry_offset(u32 term) const {
+    return static_cast<u64>(term / num_servers_) * sizeof(u64);
+  }
+
+  u64 READ_entry(u32 term, u_ptr<ComputeThread>& thread) {
+    const u32 node = term % num_servers_;
+    thread->post_balance++;
+    thread->rdma_reads_in_bytes += sizeof(u64);
+
+    thread->qps[node]->qp->post_send(thread->cas_region.get_address(),
+                                     sizeof(u64),
+                                     thread->cas_region.get_lkey(),
+                                     IBV_WR_RDMA_READ,
+                                     true,
+                                     false,
+                                     catalog_tokens_[node].get(),
+                                     get_entry_offset(term),
+                                     0,
+                                     WR_READ_NO_HANDLE);
+
+    while (thread->post_balance > 0) {
+      thread->poll_cq_and_handle();
+    }
+
+    return thread->cas_buffer;
+  }
+
+  // WRITEs an empty head block and CASes its entry, returns the entry of the
+  // head that has been published first
+  template <typename FAllocate, typename FDeallocate>
+  u64 publish_head(u32 term,
+                   u_ptr<ComputeThread>& thread,
+                   FAllocate allocate_block,
+                   FDeallocate deallocate_block) {
+    RemotePtr r = allocate_block();
+    auto& block = thread->allocation_block;
+    MRT& mrt = r.get_token(block_pools_, thread);
+
+    while (block.just_writing) {
+      thread->poll_cq_and_handle();
+    }
+
+    // READ the block (we must keep the block tag to detect ABA issues)
+    r.READ_block(block,
+                 WR_READ_NO_HANDLE,
+                 thread->allocation_region.get_lkey(),
+                 mrt,
+                 thread);
+    while (thread->post_balance > 0) {
+      thread->poll_cq_and_handle();
+    }
+
+    block.assign_entries({});
+    block.set_raw_remote_ptr(0);
+    block.set_unlock();
+
+    RemotePtr::WRITE_block(block,
+                           WR_WRITE_ALLOCATION_BLOCK,
+                           thread->allocation_region.get_lkey(),
+                           thread->qps[r.memory_node]->qp,
+                           r.offset,
+                           mrt,
+                           thread);
+    while (thread->post_balance > 0) {
+      thread->poll_cq_and_handle();
+    }
+
+    // the head is published once it is written
+    const u32 node = term % num_servers_;
+    const u64 entry = RemotePtr::encode_remote_ptr(
+      block.get_block_tag(), r.memory_node, r.offset);
+
+    thread->post_balance++;
+    thread->post_balance_CAS++;
+    thread->qps[node]->qp->post_CAS(thread->cas_region,
+                                    catalog_tokens_[node].get(),
+                                    get_entry_offset(term),
+                                    0,
+                                    entry);
+
+    while (thread->post_balance_CAS > 0) {
+      thread->poll_cq_and_handle();
+    }
+
+    if (thread->cas_buffer == 0) {
+      thread->created_heads++;
+      return entry;
+    }
+
+    // another compute thread has published a head meanwhile, ours has never
+    // been reachable
+    deallocate_block(r);
+    return thread->cas_buffer;
+  }
+
+private:
+  const u32 max_term_;
+  const u32 num_servers_;
+  MemoryRegionTokens& catalog_tokens_;
+  RemotePointers& remote_pointers_;
+  BlockPools& block_pools_;
+
+  u_ptr<std::atomic<bool>[]> known_;
+  std::mutex mutex_;  // serializes the assignments of remote pointers
+};
+
+}  // namespace inv_index::block_based::dynamic
+
+#endif  // INDEX_BLOCK_BASED_DYNAMIC_TERM_CATALOG_HH
@@ -3,6 +3,7 @@
 
 #include <library/memory_region.hh>
 #include <library/types.hh>
+#include <set>
 
 #include "compute_thread.hh"
 #include "index/query/query.hh"
@@ -11,11 +12,11 @@
 namespace inv_index::block_based::dynamic {
 
 bool verify_block(RemotePtr::BufferBlock& block, u32 id) {
-  const u32 entries = block.block_length - DYNAMIC_FOOTER_SIZE / sizeof(u32);
+  const u32 entries = block.block_length - block.footer_length;
   u32 previous_entry = 0;
 
   for (u32 idx = 0; idx < entries; ++idx) {
-    if (idx % CACHE_LINE_ITEMS != 0) {
+    if (!block.is_version_slot(idx)) {
       const u32 entry = block.buffer[idx];
 
       if (entry == static_cast<u32>(-1)) {
@@ -35,44 +36,75 @@ bool verify_block(RemotePtr::BufferBlock& block, u32 id) {
   return false;
 }
 
+bool verify_list(RemotePtr& head,
+                 u32 id,
+                 u_ptr<ComputeThread>& thread,
+                 BlockPools& block_pools) {
+  u32 node = head.memory_node;
+  u32 offset = head.offset;
+
+  auto& block = thread->read_buffer.get_block(0, 0);
+  bool verification_successful = false;
+
+  do {
+    RemotePtr r_ptr{node, offset};
+
+    // TODO: set NO_HANDLE
+    r_ptr.READ_block(0, 0, block_pools, thread);
+
+    while (thread->post_balance > 0) {
+      thread->poll_cq();
+    }
+
+    verification_successful |= verify_block(block, id);
+
+    auto [next_node, next_offset] = block.get_remote_ptr();
+    node = next_node;
+    offset = next_offset;
+  } while (!block.points_to_null() && !verification_successful);
+
+  return verification_successful;
+}
+
 void verify(query::Queries& queries,
             RemotePointers& remote_pointers_,
             u_ptr<ComputeThread>& thread,
-            MemoryRegionTokens& remote_access_tokens) {
+            BlockPools& block_pools) {
   u32 cnt = 0;
 
+  // the outcome is undefined if the same posting is inserted and deleted
+  std::set<std::pair<u32, u32>> inserted;  // term, id
+  std::set<std::pair<u32, u32>> deleted;   // term, id
+
+  for (auto& query : queries) {
+    for (u32 key : query.keys) {
+      if (query.type == QueryType::INSERT) {
+        inserted.emplace(key, query.update_id);
+      } else if (query.type == QueryType::DELETE) {
+        deleted.emplace(key, query.update_id);
+      }
+    }
+  }
+
   for (auto& query : queries) {
-    if (query.type == QueryType::INSERT) {
+    if (query.type == QueryType::INSERT || query.type == QueryType::DELETE) {
       if (cnt++ % std::max<u32>(queries.size() / 10, 1) == 0) {
         std::cerr << "verify query " << query << std::endl;
       }
 
-      for (u32 k_idx = 0; k_idx < query.size(); ++k_idx) {
-        u32 node = remote_pointers_[query.keys[k_idx]].memory_node;
-        u32 offset = remote_pointers_[query.keys[k_idx]].offset;
-
-        auto& block = thread->read_buffer.get_block(0, 0);
-        bool verification_successful = false;
+      const bool insert = query.type == QueryType::INSERT;
 
-        do {
-          RemotePtr r_ptr{node, offset};
-          MRT& mrt = remote_access_tokens[node];
-
-          // TODO: set NO_HANDLE
-          r_ptr.READ_block(0, 0, mrt, thread);
-
-          while (thread->post_balance > 0) {
-            thread->poll_cq();
-          }
-
-          verification_successful |= verify_block(block, query.update_id);
-
-          auto [next_node, next_offset] = block.get_remote_ptr();
-          node = next_node;
-          offset = next_offset;
-        } while (!block.points_to_null() && !verification_successful);
-
-        lib_assert(verification_successful, "verification failed");
+      for (u32 k_idx = 0; k_idx < query.size(); ++k_idx) {
+        const std::pair<u32, u32> posting{query.keys[k_idx], query.update_id};
+        if ((insert ? deleted : inserted).count(posting) > 0) {
+          continue;
+        }
+
+        const bool found = verify_list(remote_pointers_[query.keys[k_idx]],
+                                       query.update_id,
+                                       thread,
+                                       block_pools);
+        lib_assert(found == insert, "verification failed");
       }
     }
   }
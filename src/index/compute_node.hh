@@ -9,7 +9,9 @@
 #include "index/configuration.hh"
 #include "index/core_assignment.hh"
 #include "index/query/query.hh"
+#include "index/query/query_stream.hh"
 #include "index/statistics.hh"
+#include "term_based/query_handler.hh"
 #include "timing/timing.hh"
 
 namespace inv_index {
@@ -19,13 +21,16 @@ class ComputeNode {
   static inline constexpr bool DYNAMIC_BLOCK =
     std::is_same<QueryHandler,
                  block_based::dynamic::DynamicBlockBasedQueryHandler>::value;
+  static inline constexpr bool TERM_BASED =
+    std::is_same<QueryHandler, term_based::TermBasedQueryHandler>::value;
 
 public:
   using Configuration = configuration::IndexConfiguration;
-  using Queue = concurrent_queue<u32>;  // idx to query
-  using CoreAssignment = CoreAssignment<AssignmentPolicy::interleaved>;
+  using Queue = query::QueryStream;  // idx to query
+  using CoreAssignment = ::CoreAssignment<AssignmentPolicy::interleaved>;
   using Statistics = statistics::Statistics<DYNAMIC_BLOCK>;
   using CountItem = typename Statistics::template CountItem<u64>;
+  using LatencyHistogram = query::LatencyHistogram;
 
 public:
   explicit ComputeNode(Configuration& config);
@@ -34,8 +39,14 @@ private:
   void init_remote_tokens();
   void exchange_infos_with_compute_nodes(Configuration& config);
   void receive_remote_access_tokens();
+  void exchange_delta_logs(QueryHandler& query_handler, u32 universe_size);
+  void exchange_term_catalog(QueryHandler& query_handler, u32 max_term);
+  void ingest_documents(QueryHandler& query_handler,
+                        const str& ingest_file,
+                        u32 universe_size);
   void run_worker_threads(QueryHandler& query_handler, bool pin_threads);
   void join_threads(QueryHandler& query_handler);
+  void export_lists(QueryHandler& query_handler, const str& export_file);
   void add_meta_statistics(Configuration& config);
   void gather_statistics(vec<u64>&& raw_stats, vec<CountItem*>&& ref_stats);
   std::optional<timing::Timing::IntervalPtr> gather_timings();
@@ -48,11 +59,30 @@ private:
   const u32 num_servers_;
 
   Configuration::Operation operation_{};
+  Configuration::Distribution distribution_{};
+  bool group_queries_{};
+  Configuration::Scheduling scheduling_{};
+  u32 read_weight_{};
+  u32 writer_threads_{};
+  u32 split_threshold_{};
+  u32 insert_batch_size_{};
+  u32 insert_pipeline_depth_{};
+  bool own_terms_{};
+  u32 delta_entries_{};
+  u32 merge_fill_{};
+  u32 cache_blocks_{};
+  u32 backoff_ns_{};
+  u32 lock_lease_us_{};
+  u32 max_terms_{};
+  bool time_validation_{};
   u32 num_compute_threads_{};
   str index_directory_{};
   u32 block_size_{};
 
   MemoryRegionTokens remote_access_tokens_;
+  MemoryRegionTokens segment_table_tokens_;  // only dynamic block-based
+  MemoryRegionTokens delta_tokens_;          // only with delta logs
+  MemoryRegionTokens catalog_tokens_;        // only with new terms
   CoreAssignment core_assignment_;
 
   query::Queries queries_;
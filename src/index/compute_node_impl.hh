@@ -24,6 +24,8 @@ ComputeNode<QueryHandler>::ComputeNode(Configuration& config)
   if (cm_.is_initiator) {
     // communicate the index file to the memory nodes
     u32 i = 0;
+    // the compaction thread needs its own QPs
+    u32 num_threads = config.num_threads + (config.uses_compactor() ? 1 : 0);
 
     for (QP& qp : cm_.server_qps) {
       str index_file = config.index_dir + QueryHandler::name;
@@ -35,7 +37,7 @@ ComputeNode<QueryHandler>::ComputeNode(Configuration& config)
       index_file += "_m" + std::to_string(++i) + "_of" +
                     std::to_string(num_servers_) + "_index.dat";
       u32 len = index_file.size();
-      qp->post_send_u32(config.num_threads, false);
+      qp->post_send_u32(num_threads, false);
       qp->post_send_u32(len, false);
       qp->post_send_inlined(index_file.data(), len, IBV_WR_SEND);
       context_.poll_send_cq_until_completion();
@@ -80,38 +82,109 @@ ComputeNode<QueryHandler>::ComputeNode(Configuration& config)
   QueryHandler query_handler{
     num_compute_threads_, config.max_send_queue_wr, block_size_};
   if constexpr (DYNAMIC_BLOCK) {
-    query_handler.assign_free_lists(free_list_offsets, remote_access_tokens_);
+    query_handler.assign_block_pools(
+      free_list_offsets, remote_access_tokens_, segment_table_tokens_);
+    query_handler.set_insert_batch_size(insert_batch_size_);
+    query_handler.set_insert_pipeline_depth(insert_pipeline_depth_);
+    query_handler.set_merge_fill(merge_fill_);
+    query_handler.set_run_compactor(cm_.is_initiator);
+    query_handler.set_cache_blocks(cache_blocks_);
+    query_handler.set_contention(backoff_ns_, lock_lease_us_);
+    query_handler.set_max_terms(max_terms_);
+    query_handler.set_time_validation(time_validation_);
+    if (own_terms_) {
+      query_handler.enable_term_ownership(cm_.client_id, cm_.num_total_clients);
+    }
+  }
+  if constexpr (TERM_BASED) {
+    query_handler.set_split_threshold(split_threshold_);
   }
 
   print_status("read meta data and assign remote pointers");
   const auto [universe_size, catalog_size] =
     query_handler.assign_remote_pointers(num_servers_, index_directory_);
 
+  // inserts may add terms beyond the universe of the meta files
+  const u32 max_term =
+    std::max(universe_size, max_terms_ > 0 ? max_terms_ - 1 : 0);
+
+  if constexpr (DYNAMIC_BLOCK) {
+    exchange_delta_logs(query_handler, max_term);
+    exchange_term_catalog(query_handler, max_term);
+  }
+
   if (cm_.is_initiator) {
     query::QueryStatistics query_stats =
       query::read_queries(config.query_file, queries_);
-    lib_assert(query_stats.universe_size <= universe_size,
+    lib_assert(query_stats.universe_size <= max_term,
                "universe of query keys is too large");
+    lib_assert(delta_entries_ == 0 || query_stats.num_deletes == 0,
+               "delete queries require in-place updates");
     statistics_.num_queries.add(queries_.size());
     statistics_.universe_size.add(universe_size);
     statistics_.catalog_size.add(catalog_size);
     statistics_.num_read_queries.add(query_stats.num_reads);
     statistics_.num_insert_queries.add(query_stats.num_inserts);
+    statistics_.num_delete_queries.add(query_stats.num_deletes);
 
     if (cm_.num_total_clients > 1) {
       auto t_distribute_queries = timing_.create_enroll("distribute_queries");
       t_distribute_queries->start();
-      query::distribute_queries(
-        queries_, context_, cm_.client_qps, cm_.num_total_clients);
+      if (distribution_ == Configuration::Distribution::dynamic_dist) {
+        query_queue_.publish(
+          queries_, context_, cm_.client_qps, config.chunk_size);
+      } else {
+        vec<u64> costs(queries_.size());
+        for (u32 idx = 0; idx < queries_.size(); ++idx) {
+          costs[idx] = query::estimate_cost(
+            queries_[idx],
+            [&](u32 term) { return query_handler.get_list_length(term); },
+            operation_ == Configuration::Operation::intersection);
+        }
+
+        query::Assignment assignment =
+          distribution_ == Configuration::Distribution::cost_dist
+            ? query::assign_by_cost(queries_, cm_.num_total_clients, costs)
+            : query::assign_by_id(queries_, cm_.num_total_clients);
+        statistics_.add_static_stat(
+          "predicted_node_costs",
+          query::predicted_costs(assignment, costs, cm_.num_total_clients));
+
+        // writes are sent to the compute nodes owning their terms
+        if (own_terms_) {
+          query::route_updates(
+            queries_,
+            assignment,
+            query::TermOwners{cm_.num_total_clients, num_compute_threads_});
+        }
+
+        query::distribute_queries(queries_,
+                                  context_,
+                                  cm_.client_qps,
+                                  cm_.num_total_clients,
+                                  assignment);
+      }
       t_distribute_queries->stop();
     }
+  } else if (distribution_ == Configuration::Distribution::dynamic_dist) {
+    query_queue_.subscribe(queries_, context_, cm_.initiator_qp);
   } else {
     query::receive_queries(queries_, context_, cm_.initiator_qp);
   }
 
-  // insert queries into working queue
-  for (u32 idx = 0; idx < queries_.size(); ++idx) {
-    query_queue_.enqueue(idx);
+  // insert queries into working queues (dynamic: claimed while processing)
+  query_queue_.init(num_compute_threads_);
+  if (scheduling_ != Configuration::Scheduling::fifo_sched) {
+    query_queue_.separate_writes(
+      scheduling_ == Configuration::Scheduling::weighted_sched ? read_weight_
+                                                               : 0,
+      scheduling_ == Configuration::Scheduling::dedicated_sched
+        ? writer_threads_
+        : 0);
+  }
+  if (distribution_ != Configuration::Distribution::dynamic_dist ||
+      cm_.num_total_clients == 1) {
+    query_queue_.assign(queries_, group_queries_);
   }
 
   print_status("allocate worker threads and read buffers");
@@ -122,10 +195,24 @@ ComputeNode<QueryHandler>::ComputeNode(Configuration& config)
   // notify memory nodes that we are ready
   cm_.synchronize();
 
+  if constexpr (DYNAMIC_BLOCK) {
+    if (cm_.is_initiator && !config.ingest_file.empty()) {
+      ingest_documents(query_handler, config.ingest_file, max_term);
+    }
+  }
+
   // run queries
   run_worker_threads(query_handler, !config.disable_thread_pinning);
   join_threads(query_handler);
 
+  // the other compute nodes have sent their statistics, i.e., the writes are
+  // quiesced
+  if constexpr (DYNAMIC_BLOCK) {
+    if (cm_.is_initiator && !config.export_file.empty()) {
+      export_lists(query_handler, config.export_file);
+    }
+  }
+
 #ifdef VERIFY
   if constexpr (DYNAMIC_BLOCK) {
     // wait to make sure that all the other compute nodes are done as well
@@ -134,7 +221,7 @@ ComputeNode<QueryHandler>::ComputeNode(Configuration& config)
     verify(queries_,
            query_handler.get_remote_pointers(),
            query_handler.get_compute_threads().front(),
-           remote_access_tokens_);
+           query_handler.get_block_pools());
   }
 #endif
 
@@ -155,6 +242,14 @@ void ComputeNode<QueryHandler>::init_remote_tokens() {
     // ownership has the vector
     mrt = std::make_unique<MemoryRegionToken>();
   }
+
+  if constexpr (DYNAMIC_BLOCK) {
+    segment_table_tokens_.resize(num_servers_);
+
+    for (auto& mrt : segment_table_tokens_) {
+      mrt = std::make_unique<MemoryRegionToken>();
+    }
+  }
 }
 
 template <class QueryHandler>
@@ -167,6 +262,22 @@ void ComputeNode<QueryHandler>::exchange_infos_with_compute_nodes(
     u32 operation;
     u32 directory_size;
     u32 block_size;
+    u32 distribution;
+    u32 group_queries;
+    u32 scheduling;
+    u32 read_weight;
+    u32 writer_threads;
+    u32 split_threshold;
+    u32 insert_batch_size;
+    u32 insert_pipeline_depth;
+    u32 own_terms;
+    u32 delta_entries;
+    u32 merge_fill;
+    u32 cache_blocks;
+    u32 backoff_ns;
+    u32 lock_lease_us;
+    u32 max_terms;
+    u32 time_validation;
   };
 
   if (cm_.is_initiator) {
@@ -174,11 +285,43 @@ void ComputeNode<QueryHandler>::exchange_infos_with_compute_nodes(
     operation_ = config.get_operation();
     index_directory_ = config.index_dir;
     block_size_ = config.block_size;
+    distribution_ = config.get_distribution();
+    group_queries_ = config.group_queries;
+    scheduling_ = config.get_scheduling();
+    read_weight_ = config.read_weight;
+    writer_threads_ = config.writer_threads;
+    split_threshold_ = config.split_threshold;
+    insert_batch_size_ = config.insert_batch;
+    insert_pipeline_depth_ = config.insert_pipeline;
+    own_terms_ = config.own_terms;
+    delta_entries_ = config.delta_entries;
+    merge_fill_ = config.merge_fill;
+    cache_blocks_ = config.cache_blocks;
+    backoff_ns_ = config.backoff_ns;
+    lock_lease_us_ = config.lock_lease_us;
+    max_terms_ = config.max_terms;
+    time_validation_ = config.time_validation;
 
     CInfo info{config.num_threads,
                operation_,
                static_cast<u32>(index_directory_.size()),
-               block_size_};
+               block_size_,
+               distribution_,
+               group_queries_,
+               scheduling_,
+               read_weight_,
+               writer_threads_,
+               split_threshold_,
+               insert_batch_size_,
+               insert_pipeline_depth_,
+               own_terms_,
+               delta_entries_,
+               merge_fill_,
+               cache_blocks_,
+               backoff_ns_,
+               lock_lease_us_,
+               max_terms_,
+               time_validation_};
 
     for (QP& qp : cm_.client_qps) {
       qp->post_send_inlined(std::addressof(info), sizeof(info), IBV_WR_SEND);
@@ -195,6 +338,22 @@ void ComputeNode<QueryHandler>::exchange_infos_with_compute_nodes(
     num_compute_threads_ = info.compute_threads;
     operation_ = static_cast<Configuration::Operation>(info.operation);
     block_size_ = info.block_size;
+    distribution_ = static_cast<Configuration::Distribution>(info.distribution);
+    group_queries_ = info.group_queries;
+    scheduling_ = static_cast<Configuration::Scheduling>(info.scheduling);
+    read_weight_ = info.read_weight;
+    writer_threads_ = info.writer_threads;
+    split_threshold_ = info.split_threshold;
+    insert_batch_size_ = info.insert_batch_size;
+    insert_pipeline_depth_ = info.insert_pipeline_depth;
+    own_terms_ = info.own_terms;
+    delta_entries_ = info.delta_entries;
+    merge_fill_ = info.merge_fill;
+    cache_blocks_ = info.cache_blocks;
+    backoff_ns_ = info.backoff_ns;
+    lock_lease_us_ = info.lock_lease_us;
+    max_terms_ = info.max_terms;
+    time_validation_ = info.time_validation;
 
     u32 index_dir_size = info.directory_size;
     index_directory_.resize(index_dir_size);
@@ -224,7 +383,129 @@ void ComputeNode<QueryHandler>::receive_remote_access_tokens() {
       context_, mrt.get(), sizeof(MemoryRegionToken)};
     qp->post_receive(token_region);
     context_.receive();
+
+    // segments of the block pool are looked up in a remote table
+    if constexpr (DYNAMIC_BLOCK) {
+      MRT& table_mrt = segment_table_tokens_[memory_node];
+      LocalMemoryRegion table_token_region{
+        context_, table_mrt.get(), sizeof(MemoryRegionToken)};
+      qp->post_receive(table_token_region);
+      context_.receive();
+    }
+  }
+}
+
+template <class QueryHandler>
+void ComputeNode<QueryHandler>::exchange_delta_logs(QueryHandler& query_handler,
+                                                    u32 universe_size) {
+  // the memory nodes allocate the logs once the universe size is known
+  if (cm_.is_initiator) {
+    u32 num_terms = block_based::dynamic::DeltaLayout::get_num_terms(
+      universe_size, num_servers_);
+
+    for (QP& qp : cm_.server_qps) {
+      qp->post_send_u32(delta_entries_, false);
+      qp->post_send_u32(num_terms, true);
+      context_.poll_send_cq_until_completion();
+    }
+  }
+
+  if (delta_entries_ == 0) {
+    return;
+  }
+
+  print_status("receive access tokens of delta logs");
+  delta_tokens_.resize(num_servers_);
+
+  for (u32 memory_node = 0; memory_node < num_servers_; ++memory_node) {
+    MRT& mrt = delta_tokens_[memory_node];
+    mrt = std::make_unique<MemoryRegionToken>();
+
+    LocalMemoryRegion token_region{
+      context_, mrt.get(), sizeof(MemoryRegionToken)};
+    cm_.server_qps[memory_node]->post_receive(token_region);
+    context_.receive();
+  }
+
+  query_handler.enable_delta_buffers(
+    delta_entries_, universe_size, delta_tokens_);
+}
+
+template <class QueryHandler>
+void ComputeNode<QueryHandler>::exchange_term_catalog(
+  QueryHandler& query_handler,
+  u32 max_term) {
+  // the memory nodes allocate the catalog entries of their terms
+  if (cm_.is_initiator) {
+    u32 num_entries = max_terms_ == 0
+                        ? 0
+                        : block_based::dynamic::TermCatalog::get_num_entries(
+                            max_term, num_servers_);
+
+    for (QP& qp : cm_.server_qps) {
+      qp->post_send_u32(num_entries, true);
+      context_.poll_send_cq_until_completion();
+    }
+  }
+
+  if (max_terms_ == 0) {
+    return;
+  }
+
+  print_status("receive access tokens of the term catalog");
+  catalog_tokens_.resize(num_servers_);
+
+  for (u32 memory_node = 0; memory_node < num_servers_; ++memory_node) {
+    MRT& mrt = catalog_tokens_[memory_node];
+    mrt = std::make_unique<MemoryRegionToken>();
+
+    LocalMemoryRegion token_region{
+      context_, mrt.get(), sizeof(MemoryRegionToken)};
+    cm_.server_qps[memory_node]->post_receive(token_region);
+    context_.receive();
+  }
+
+  query_handler.enable_term_catalog(max_term, catalog_tokens_);
+}
+
+template <class QueryHandler>
+void ComputeNode<QueryHandler>::ingest_documents(QueryHandler& query_handler,
+                                                 const str& ingest_file,
+                                                 u32 universe_size) {
+  const auto lists =
+    block_based::dynamic::invert_documents(ingest_file, universe_size);
+
+  u64 num_postings = 0;
+  for (const auto& list : lists) {
+    num_postings += list.size();
   }
+
+  print_status("ingest " + std::to_string(num_postings) + " postings");
+  auto t_ingest = timing_.create_enroll("bulk_ingest");
+  t_ingest->start();
+  query_handler.bulk_ingest(lists);
+  t_ingest->stop();
+
+  const f64 ingest_time = t_ingest->get_ms() / 1000.0;  // in sec
+  statistics_.add_static_stat(
+    "ingest_postings_per_sec", static_cast<u64>(num_postings / ingest_time));
+}
+
+template <class QueryHandler>
+void ComputeNode<QueryHandler>::export_lists(QueryHandler& query_handler,
+                                             const str& export_file) {
+  print_status("export lists to " + export_file);
+  auto t_export = timing_.create_enroll("export_lists");
+  t_export->start();
+  const auto lists = query_handler.export_lists();
+  const u64 num_postings =
+    block_based::dynamic::write_serialized_lists(export_file, lists);
+  t_export->stop();
+
+  const f64 export_time = t_export->get_ms() / 1000.0;  // in sec
+  statistics_.add_static_stat("exported_postings", num_postings);
+  statistics_.add_static_stat(
+    "export_postings_per_sec", static_cast<u64>(num_postings / export_time));
 }
 
 template <class QueryHandler>
@@ -258,6 +539,11 @@ void ComputeNode<QueryHandler>::run_worker_threads(QueryHandler& query_handler,
   query_handler.process_queries(
     query_queue_, queries_, remote_access_tokens_, operation_, 0);
   t_query_->stop();
+
+  if (distribution_ == Configuration::Distribution::dynamic_dist) {
+    std::cerr << "claimed chunks: " << query_queue_.get_claimed_chunks()
+              << std::endl;
+  }
 }
 
 template <class QueryHandler>
@@ -265,16 +551,64 @@ void ComputeNode<QueryHandler>::join_threads(QueryHandler& query_handler) {
   print_status("join compute threads");
   u64 num_result = 0;
   u64 rdma_reads_in_bytes = 0;
+  u64 dequeue_time_us = 0;
+  u64 stolen_batches = 0;
 
+  // latencies of reads and writes (see LatencyHistogram)
+  vec<u64> sum_read_latencies(LatencyHistogram::NUM_BUCKETS);
+  vec<u64> sum_write_latencies(LatencyHistogram::NUM_BUCKETS);
+
+  u64 sum_rdma_writes_in_bytes = 0;
   u64 sum_remote_allocations = 0;
   u64 sum_remote_deallocations = 0;
   u64 sum_block_repeated_reads = 0;
   u64 sum_list_repeated_reads = 0;
+  u64 sum_insert_commits = 0;
+  u64 sum_tail_hint_hits = 0;
+  u64 sum_tail_hint_misses = 0;
+  u64 sum_free_list_refills = 0;
+  u64 sum_free_list_cas_failed = 0;
+  u64 sum_pool_growths = 0;
+  u64 sum_slot_reservations = 0;
+  u64 sum_reservation_failed = 0;
+  u64 sum_pipelined_inserts = 0;
+  u64 sum_pipeline_fallbacks = 0;
+  u64 sum_forwarded_updates = 0;
+  u64 sum_delta_appends = 0;
+  u64 sum_delta_full = 0;
+  u64 sum_delta_reads_in_bytes = 0;
+  u64 sum_ingested_postings = 0;
+  u64 sum_ingested_blocks = 0;
+  u64 sum_cache_hits = 0;
+  u64 sum_cache_stale = 0;
+  u64 sum_stale_locks_released = 0;
+  u64 sum_lost_locks = 0;
+  u64 sum_stale_blocks = 0;
+  u64 sum_query_restarts = 0;
+  u64 sum_created_heads = 0;
+  u64 sum_catalog_pulls = 0;
+  u64 sum_validated_blocks = 0;
+  u64 sum_timed_validations = 0;
+  u64 sum_validation_time_us = 0;
+  u64 sum_backoff_time_us = 0;
+  u64 sum_merged_blocks = 0;
+  u64 sum_compactor_reads_in_bytes = 0;
+  u64 sum_compacted_entries = 0;
 
   u64 sum_locking_failed = 0;
   u64 sum_read_failed = 0;
   u64 sum_wait_for_write = 0;
 
+  // contention histograms (see RetryHistogram)
+  vec<u64> sum_lock_retries(block_based::CONTENTION_BUCKETS);
+  vec<u64> sum_free_list_retries(block_based::CONTENTION_BUCKETS);
+  const auto add_histograms = [&](auto& t) {
+    for (u32 b = 0; b < block_based::CONTENTION_BUCKETS; ++b) {
+      sum_lock_retries[b] += t->lock_retries.buckets[b];
+      sum_free_list_retries[b] += t->free_list_retries.buckets[b];
+    }
+  };
+
   for (auto& t : query_handler.get_compute_threads()) {
     // no need for joining the main thread
     if (t->get_id() != 0) {
@@ -285,46 +619,237 @@ void ComputeNode<QueryHandler>::join_threads(QueryHandler& query_handler) {
 
     rdma_reads_in_bytes += t->rdma_reads_in_bytes;
     num_result += t->local_num_result;
+    dequeue_time_us +=
+      static_cast<u64>(query_queue_.get_dequeue_ms(t->get_id()) * 1000.0);
+    stolen_batches += query_queue_.get_steals(t->get_id());
+    for (u32 b = 0; b < LatencyHistogram::NUM_BUCKETS; ++b) {
+      sum_read_latencies[b] += query_queue_.get_read_latencies(t->get_id())
+                                 .buckets[b];
+      sum_write_latencies[b] += query_queue_.get_write_latencies(t->get_id())
+                                  .buckets[b];
+    }
     std::cerr << "t" << t->get_id()
-              << " processed queries: " << t->processed_queries;
+              << " processed queries: " << t->processed_queries
+              << ", batches: " << query_queue_.get_bulk_dequeues(t->get_id())
+              << ", stolen: " << query_queue_.get_steals(t->get_id())
+              << ", dequeue: " << query_queue_.get_dequeue_ms(t->get_id());
+    if constexpr (TERM_BASED) {
+      std::cerr << ", split: " << t->split_queries;
+    }
     if constexpr (DYNAMIC_BLOCK) {
+      sum_rdma_writes_in_bytes += t->rdma_writes_in_bytes;
       sum_remote_allocations += t->remote_allocations;
       sum_remote_deallocations += t->remote_deallocations;
       sum_block_repeated_reads += t->block_repeated_reads;
       sum_list_repeated_reads += t->list_repeated_reads;
+      sum_insert_commits += t->insert_commits;
+      sum_tail_hint_hits += t->tail_hint_hits;
+      sum_tail_hint_misses += t->tail_hint_misses;
+      sum_free_list_refills += t->free_list_refills;
+      sum_free_list_cas_failed += t->free_list_cas_failed;
+      sum_pool_growths += t->pool_growths;
+      sum_slot_reservations += t->slot_reservations;
+      sum_reservation_failed += t->reservation_failed;
+      sum_pipelined_inserts += t->pipelined_inserts;
+      sum_pipeline_fallbacks += t->pipeline_fallbacks;
+      sum_forwarded_updates += t->forwarded_updates;
+      sum_delta_appends += t->delta_appends;
+      sum_delta_full += t->delta_full;
+      sum_delta_reads_in_bytes += t->delta_reads_in_bytes;
+      sum_ingested_postings += t->ingested_postings;
+      sum_ingested_blocks += t->ingested_blocks;
+      sum_cache_hits += t->cache_hits;
+      sum_cache_stale += t->cache_stale;
+      sum_stale_locks_released += t->stale_locks_released;
+      sum_lost_locks += t->lost_locks;
+      sum_stale_blocks += t->stale_blocks;
+      sum_query_restarts += t->query_restarts;
+      sum_created_heads += t->created_heads;
+      sum_catalog_pulls += t->catalog_pulls;
+      sum_validated_blocks += t->validated_blocks;
+      sum_timed_validations += t->timed_validations;
+      sum_validation_time_us += t->validation_time_ns / 1000;
+      sum_backoff_time_us += t->backoff.waited_ns / 1000;
+      add_histograms(t);
       sum_read_failed += t->read_failed;
       sum_locking_failed += t->locking_failed;
       sum_wait_for_write += t->wait_for_write;
-      std::cerr << ", remote allocations: " << t->remote_allocations
+      std::cerr << ", WRITE bytes: " << t->rdma_writes_in_bytes
+                << ", remote allocations: " << t->remote_allocations
                 << ", remote deallocations: " << t->remote_deallocations
                 << ", block repeated READs: " << t->block_repeated_reads
-                << ", list repeated READs: " << t->list_repeated_reads;
+                << ", list repeated READs: " << t->list_repeated_reads
+                << ", insert commits: " << t->insert_commits
+                << ", tail hits: " << t->tail_hint_hits
+                << ", tail misses: " << t->tail_hint_misses
+                << ", free list refills: " << t->free_list_refills
+                << ", free list CAS failed: " << t->free_list_cas_failed
+                << ", pool growths: " << t->pool_growths
+                << ", slot reservations: " << t->slot_reservations
+                << ", reservation failed: " << t->reservation_failed
+                << ", pipelined inserts: " << t->pipelined_inserts
+                << ", pipeline fallbacks: " << t->pipeline_fallbacks
+                << ", forwarded updates: " << t->forwarded_updates
+                << ", delta appends: " << t->delta_appends
+                << ", delta full: " << t->delta_full
+                << ", delta READ bytes: " << t->delta_reads_in_bytes
+                << ", ingested postings: " << t->ingested_postings
+                << ", ingested blocks: " << t->ingested_blocks
+                << ", cache hits: " << t->cache_hits
+                << ", stale cached blocks: " << t->cache_stale
+                << ", stale locks released: " << t->stale_locks_released
+                << ", lost locks: " << t->lost_locks
+                << ", stale blocks: " << t->stale_blocks
+                << ", query restarts: " << t->query_restarts
+                << ", created heads: " << t->created_heads
+                << ", catalog pulls: " << t->catalog_pulls
+                << ", validated blocks: " << t->validated_blocks
+                << ", validation time (us): " << t->validation_time_ns / 1000
+                << ", backoff (us): " << t->backoff.waited_ns / 1000;
     }
     std::cerr << ", READ lists: " << t->t_read_list->get_ms()
               << ", polling: " << t->t_poll->get_ms()
               << ", operation: " << t->t_operation->get_ms() << std::endl;
   }
 
+  // the compaction thread (delta logs and block merges) is joined by the
+  // query handler
+  if constexpr (DYNAMIC_BLOCK) {
+    if (auto* t = query_handler.get_compactor()) {
+      lib_assert(t->post_balance == 0, "incomplete compaction");
+
+      rdma_reads_in_bytes += t->rdma_reads_in_bytes;
+      sum_rdma_writes_in_bytes += t->rdma_writes_in_bytes;
+      sum_remote_allocations += t->remote_allocations;
+      sum_block_repeated_reads += t->block_repeated_reads;
+      sum_list_repeated_reads += t->list_repeated_reads;
+      sum_insert_commits += t->insert_commits;
+      sum_pool_growths += t->pool_growths;
+      sum_compacted_entries += t->compacted_entries;
+      sum_merged_blocks += t->merged_blocks;
+      sum_remote_deallocations += t->remote_deallocations;
+      sum_compactor_reads_in_bytes += t->rdma_reads_in_bytes;
+      sum_stale_locks_released += t->stale_locks_released;
+      sum_validated_blocks += t->validated_blocks;
+      sum_backoff_time_us += t->backoff.waited_ns / 1000;
+      add_histograms(t);
+      std::cerr << "compactor compacted entries: " << t->compacted_entries
+                << ", merged blocks: " << t->merged_blocks
+                << ", WRITE bytes: " << t->rdma_writes_in_bytes
+                << ", remote allocations: " << t->remote_allocations
+                << ", insert commits: " << t->insert_commits << std::endl;
+    }
+  }
+
   // collect statistics
-  gather_statistics(
-    {num_result, rdma_reads_in_bytes},
-    {&statistics_.num_result, &statistics_.rdma_reads_in_bytes});
+  gather_statistics({num_result,
+                     rdma_reads_in_bytes,
+                     dequeue_time_us,
+                     stolen_batches},
+                    {&statistics_.num_result,
+                     &statistics_.rdma_reads_in_bytes,
+                     &statistics_.dequeue_time_us,
+                     &statistics_.stolen_batches});
+
+  vec<u64> raw_latencies;
+  vec<CountItem*> ref_latencies;
+  for (u32 b = 0; b < LatencyHistogram::NUM_BUCKETS; ++b) {
+    raw_latencies.push_back(sum_read_latencies[b]);
+    ref_latencies.push_back(&statistics_.read_latency.buckets[b]);
+    raw_latencies.push_back(sum_write_latencies[b]);
+    ref_latencies.push_back(&statistics_.write_latency.buckets[b]);
+  }
+  gather_statistics(std::move(raw_latencies), std::move(ref_latencies));
 
   if constexpr (DYNAMIC_BLOCK) {
-    gather_statistics({sum_remote_allocations,
+    gather_statistics({sum_rdma_writes_in_bytes,
+                       sum_remote_allocations,
                        sum_remote_deallocations,
                        sum_block_repeated_reads,
                        sum_list_repeated_reads,
+                       sum_insert_commits,
+                       sum_tail_hint_hits,
+                       sum_tail_hint_misses,
+                       sum_free_list_refills,
+                       sum_free_list_cas_failed,
+                       sum_pool_growths,
+                       sum_slot_reservations,
+                       sum_reservation_failed,
+                       sum_pipelined_inserts,
+                       sum_pipeline_fallbacks,
+                       sum_forwarded_updates,
+                       sum_delta_appends,
+                       sum_delta_full,
+                       sum_delta_reads_in_bytes,
+                       sum_ingested_postings,
+                       sum_ingested_blocks,
+                       sum_cache_hits,
+                       sum_cache_stale,
+                       sum_stale_locks_released,
+                       sum_lost_locks,
+                       sum_stale_blocks,
+                       sum_query_restarts,
+                       sum_created_heads,
+                       sum_catalog_pulls,
+                       sum_validated_blocks,
+                       sum_timed_validations,
+                       sum_validation_time_us,
+                       sum_backoff_time_us,
+                       sum_merged_blocks,
+                       sum_compactor_reads_in_bytes,
+                       sum_compacted_entries,
                        sum_read_failed,
                        sum_wait_for_write,
                        sum_locking_failed},
-                      {&statistics_.remote_allocations,
+                      {&statistics_.rdma_writes_in_bytes,
+                       &statistics_.remote_allocations,
                        &statistics_.remote_deallocations,
                        &statistics_.block_repeated_reads,
                        &statistics_.list_repeated_reads,
+                       &statistics_.insert_commits,
+                       &statistics_.tail_hint_hits,
+                       &statistics_.tail_hint_misses,
+                       &statistics_.free_list_refills,
+                       &statistics_.free_list_cas_failed,
+                       &statistics_.pool_growths,
+                       &statistics_.slot_reservations,
+                       &statistics_.reservation_failed,
+                       &statistics_.pipelined_inserts,
+                       &statistics_.pipeline_fallbacks,
+                       &statistics_.forwarded_updates,
+                       &statistics_.delta_appends,
+                       &statistics_.delta_full,
+                       &statistics_.delta_reads_in_bytes,
+                       &statistics_.ingested_postings,
+                       &statistics_.ingested_blocks,
+                       &statistics_.cache_hits,
+                       &statistics_.cache_stale,
+                       &statistics_.stale_locks_released,
+                       &statistics_.lost_locks,
+                       &statistics_.stale_blocks,
+                       &statistics_.query_restarts,
+                       &statistics_.created_heads,
+                       &statistics_.catalog_pulls,
+                       &statistics_.validated_blocks,
+                       &statistics_.timed_validations,
+                       &statistics_.validation_time_us,
+                       &statistics_.backoff_time_us,
+                       &statistics_.merged_blocks,
+                       &statistics_.compactor_reads_in_bytes,
+                       &statistics_.compacted_entries,
                        &statistics_.read_failed,
                        &statistics_.wait_for_write,
                        &statistics_.locking_failed});
+
+    vec<u64> raw_histograms;
+    vec<CountItem*> ref_histograms;
+    for (u32 b = 0; b < block_based::CONTENTION_BUCKETS; ++b) {
+      raw_histograms.push_back(sum_lock_retries[b]);
+      ref_histograms.push_back(&statistics_.lock_retries.buckets[b]);
+      raw_histograms.push_back(sum_free_list_retries[b]);
+      ref_histograms.push_back(&statistics_.free_list_retries.buckets[b]);
+    }
+    gather_statistics(std::move(raw_histograms), std::move(ref_histograms));
   }
 
   // collect timings
@@ -340,6 +865,54 @@ void ComputeNode<QueryHandler>::join_threads(QueryHandler& query_handler) {
       "mb_per_sec",
       static_cast<f64>(statistics_.rdma_reads_in_bytes.count) / 1000000.0 /
         query_time);
+
+    // from the dequeue of a query's batch until the query is processed
+    const auto latency_percentiles = [](const auto& histogram) {
+      vec<u64> counts;
+      for (const auto& bucket : histogram.buckets) {
+        counts.push_back(bucket.count);
+      }
+
+      nlohmann::json percentiles;
+      for (const auto& [name, percentile] :
+           {std::make_pair("p50", 0.5),
+            std::make_pair("p90", 0.9),
+            std::make_pair("p99", 0.99),
+            std::make_pair("p999", 0.999)}) {
+        percentiles[name] =
+          LatencyHistogram::get_percentile(counts, percentile) / 1000.0;
+      }
+
+      return percentiles;
+    };
+    statistics_.add_static_stat("read_latency_us",
+                                latency_percentiles(statistics_.read_latency));
+    statistics_.add_static_stat("write_latency_us",
+                                latency_percentiles(statistics_.write_latency));
+
+    if constexpr (DYNAMIC_BLOCK) {
+      // READs of the compaction thread are not caused by queries
+      statistics_.add_static_stat(
+        "read_bytes_per_query",
+        (statistics_.rdma_reads_in_bytes.count -
+         statistics_.compactor_reads_in_bytes.count) /
+          std::max<u64>(statistics_.num_queries.count, 1));
+
+      // cost of detecting torn READs (cache line versions or crc)
+      statistics_.add_static_stat(
+        "validation_ns_per_block",
+        statistics_.validation_time_us.count * 1000.0 /
+          std::max<u64>(statistics_.timed_validations.count, 1));
+
+      if (const auto& merger = query_handler.get_block_merger()) {
+        statistics_.add_static_stat("fill_factor_before",
+                                    merger->get_fill_before());
+        statistics_.add_static_stat("fill_factor_after",
+                                    merger->get_fill_after());
+        statistics_.add_static_stat("merge_passes",
+                                    merger->get_num_passes());
+      }
+    }
   }
 }
 
@@ -364,11 +937,49 @@ void ComputeNode<QueryHandler>::add_meta_statistics(Configuration& config) {
     std::make_pair(
       "index_directory",
       name_from_path(index_directory_.substr(0, index_directory_.size() - 1))),
-    std::make_pair("query_file", name_from_path(config.query_file)));
+    std::make_pair("query_file", name_from_path(config.query_file)),
+    std::make_pair("distribution", config.distribution),
+    std::make_pair("grouped_queries",
+                   config.group_queries ? "true" : "false"),
+    std::make_pair("scheduling", config.scheduling));
+  if (config.get_scheduling() == Configuration::Scheduling::weighted_sched) {
+    statistics_.template add_meta_stat("read_weight", config.read_weight);
+  }
+  if (config.get_scheduling() == Configuration::Scheduling::dedicated_sched) {
+    statistics_.template add_meta_stat("writer_threads",
+                                       config.writer_threads);
+  }
+  if constexpr (TERM_BASED) {
+    statistics_.template add_meta_stat("split_threshold",
+                                       config.split_threshold);
+  }
   if constexpr (std::is_same<QueryHandler,
                              block_based::BlockBasedQueryHandler>::value) {
     statistics_.template add_meta_stat("block_size", config.block_size);
   }
+  if constexpr (DYNAMIC_BLOCK) {
+    statistics_.template add_meta_stat("insert_batch_size",
+                                       config.insert_batch);
+    statistics_.template add_meta_stat("insert_pipeline_depth",
+                                       config.insert_pipeline);
+    statistics_.template add_meta_stat("own_terms", config.own_terms);
+    statistics_.template add_meta_stat("delta_entries", config.delta_entries);
+    statistics_.template add_meta_stat("merge_fill", config.merge_fill);
+    statistics_.template add_meta_stat("cache_blocks", config.cache_blocks);
+    statistics_.template add_meta_stat("backoff_ns", config.backoff_ns);
+    statistics_.template add_meta_stat("lock_lease_us", config.lock_lease_us);
+    statistics_.template add_meta_stat("max_terms", config.max_terms);
+    statistics_.template add_meta_stat("time_validation",
+                                       config.time_validation);
+
+    using BufferBlock = block_based::ReadBuffer<true>::BufferBlock;
+    statistics_.template add_meta_stat(
+      "block_validation",
+      block_based::CACHE_LINE_VERSIONS ? "cache_line_versions" : "crc32c");
+    statistics_.template add_meta_stat(
+      "block_capacity",
+      BufferBlock(nullptr, config.block_size).get_capacity());
+  }
 }
 
 template <class QueryHandler>
@@ -395,8 +1006,10 @@ void ComputeNode<QueryHandler>::gather_statistics(vec<u64>&& raw_stats,
     }
 
   } else {
-    cm_.initiator_qp->post_send_inlined(
-      raw_stats.data(), raw_stats.size() * sizeof(u64), IBV_WR_SEND);
+    // the statistics may exceed the inline size
+    LocalMemoryRegion region(
+      context_, raw_stats.data(), raw_stats.size() * sizeof(u64));
+    cm_.initiator_qp->post_send(region, IBV_WR_SEND);
     context_.poll_send_cq_until_completion();
   }
 }
@@ -15,8 +15,39 @@ public:
   str operation{};
   bool disable_thread_pinning{};
   u32 block_size{};
+  str distribution{};
+  u32 chunk_size{};
+  bool group_queries{};
+  str scheduling{};
+  u32 read_weight{};
+  u32 writer_threads{};
+  u32 split_threshold{};
+  u32 insert_batch{};
+  u32 insert_pipeline{};
+  bool own_terms{};
+  u32 delta_entries{};
+  str ingest_file{};
+  str export_file{};
+  u32 merge_fill{};
+  u32 cache_blocks{};
+  u32 backoff_ns{};
+  u32 lock_lease_us{};
+  u32 max_terms{};
+  bool time_validation{};
+  u32 pool_blocks{};
+  u32 grow_blocks{};
+  str snapshot_dir{};
+  bool restore{};
+  u32 io_streams{};
 
   enum Operation { intersection, union_op };
+  enum Distribution { static_dist, cost_dist, dynamic_dist };
+  enum Scheduling {
+    fifo_sched,
+    priority_sched,
+    weighted_sched,
+    dedicated_sched
+  };
 
 public:
   IndexConfiguration(int argc, char** argv) {
@@ -34,6 +65,30 @@ public:
                                             : Operation::union_op;
   }
 
+  Distribution get_distribution() const {
+    if (distribution == str("cost")) {
+      return Distribution::cost_dist;
+    }
+
+    return distribution == str("dynamic") ? Distribution::dynamic_dist
+                                          : Distribution::static_dist;
+  }
+
+  Scheduling get_scheduling() const {
+    if (scheduling == str("priority")) {
+      return Scheduling::priority_sched;
+    }
+    if (scheduling == str("weighted")) {
+      return Scheduling::weighted_sched;
+    }
+
+    return scheduling == str("dedicated") ? Scheduling::dedicated_sched
+                                          : Scheduling::fifo_sched;
+  }
+
+  // delta logs and block merges are handled by an additional thread
+  bool uses_compactor() const { return delta_entries > 0 || merge_fill > 0; }
+
 private:
   void add_options() {
     desc.add_options()("index-dir,d",
@@ -53,10 +108,122 @@ private:
       "Disables pinning compute threads to physical cores if set.")(
       "block-size,b",
       po::value<u32>(&block_size)->default_value(1024),
-      "Block size in bytes (only used by [dynamic_]block_index).");
+      "Block size in bytes (only used by [dynamic_]block_index).")(
+      "distribution",
+      po::value<str>(&distribution)->default_value("static"),
+      R"(Distribution of queries: "static", "cost", or "dynamic".)")(
+      "chunk-size",
+      po::value<u32>(&chunk_size)->default_value(32),
+      "Number of queries claimed at once (only used by dynamic "
+      "distribution).")(
+      "group-queries",
+      po::bool_switch(&group_queries)->default_value(false),
+      "Assigns queries sharing their first term to the same compute thread.")(
+      "scheduling",
+      po::value<str>(&scheduling)->default_value("fifo"),
+      R"(Scheduling of reads and writes by the compute threads: "fifo", )"
+      R"("priority" (reads first), "weighted", or "dedicated" (writer )"
+      R"(threads).)")(
+      "read-weight",
+      po::value<u32>(&read_weight)->default_value(4),
+      "Number of batches of reads a compute thread dequeues per batch of "
+      "writes (only used by weighted scheduling).")(
+      "writer-threads",
+      po::value<u32>(&writer_threads)->default_value(1),
+      "Number of compute threads per compute node that only process writes "
+      "(only used by dedicated scheduling).")(
+      "split-threshold",
+      po::value<u32>(&split_threshold)->default_value(4194304),
+      "Total list length from which a query is split across threads, 0 "
+      "disables splitting (only used by term_index).")(
+      "insert-batch",
+      po::value<u32>(&insert_batch)->default_value(1),
+      "Number of pending inserts grouped per compute thread before they are "
+      "applied (only used by dynamic_block_index).")(
+      "insert-pipeline",
+      po::value<u32>(&insert_pipeline)->default_value(1),
+      "Number of unbatched inserts (of different terms) in flight per compute "
+      "thread (only used by dynamic_block_index).")(
+      "own-terms",
+      po::bool_switch(&own_terms)->default_value(false),
+      "Applies all writes to a term by a single owner thread of the cluster, "
+      "requires static or cost distribution (only used by "
+      "dynamic_block_index).")(
+      "delta-entries",
+      po::value<u32>(&delta_entries)->default_value(0),
+      "Capacity of the per-term delta logs inserts are appended to, 0 applies "
+      "inserts in place (only used by dynamic_block_index).")(
+      "ingest-file",
+      po::value<str>(&ingest_file),
+      "Documents file that is ingested in bulk before the queries are "
+      "processed (only used by dynamic_block_index).")(
+      "export-file",
+      po::value<str>(&export_file),
+      "Binary file (input of the partitioner) the lists are written to after "
+      "the queries are processed (only used by dynamic_block_index).")(
+      "merge-fill",
+      po::value<u32>(&merge_fill)->default_value(0),
+      "Maximum fill (in percent) of a block merged from two adjacent blocks in "
+      "the background, 0 disables merging (only used by "
+      "dynamic_block_index).")(
+      "cache-blocks",
+      po::value<u32>(&cache_blocks)->default_value(0),
+      "Number of blocks cached by a compute node (validated by READing their "
+      "footers), 0 disables caching (only used by dynamic_block_index).")(
+      "backoff-ns",
+      po::value<u32>(&backoff_ns)->default_value(0),
+      "Maximum randomized exponential backoff (in ns) before retrying a "
+      "failed CAS of a block lock or a free list head, 0 retries immediately "
+      "(only used by dynamic_block_index).")(
+      "lock-lease-us",
+      po::value<u32>(&lock_lease_us)->default_value(0),
+      "Time (in us) after which an unchanged block lock is considered stale "
+      "and released by a waiting thread, 0 disables leases (only used by "
+      "dynamic_block_index).")(
+      "max-terms",
+      po::value<u32>(&max_terms)->default_value(0),
+      "Number of terms inserts may add to (terms without a list get a head "
+      "block published in a remote catalog), 0 disables new terms (only used "
+      "by dynamic_block_index).")(
+      "time-validation",
+      po::bool_switch(&time_validation)->default_value(false),
+      "Times the validation of every READ block (adds two clock reads per "
+      "block to the READ path, only used by dynamic_block_index).")(
+      "pool-blocks",
+      po::value<u32>(&pool_blocks)->default_value(1000000),
+      "Number of free blocks initially allocated by a memory node, 0 uses all "
+      "available huge pages (only used by dynamic_block_index).")(
+      "grow-blocks",
+      po::value<u32>(&grow_blocks)->default_value(1000000),
+      "Number of blocks a memory node adds to its pool when running out of "
+      "blocks, 0 disables growing (only used by dynamic_block_index).")(
+      "snapshot-dir",
+      po::value<str>(&snapshot_dir),
+      "Directory a memory node writes a snapshot of its blocks to once all "
+      "compute nodes are done (only used by dynamic_block_index).")(
+      "restore",
+      po::bool_switch(&restore)->default_value(false),
+      "Starts a memory node from its snapshot in the snapshot directory "
+      "instead of the index file (only used by dynamic_block_index).")(
+      "io-streams",
+      po::value<u32>(&io_streams)->default_value(4),
+      "Number of parallel streams a memory node reads its index file (or "
+      "snapshot) with.");
   }
 
   void validate_program_options(char** argv) {
+    if (is_server && io_streams == 0) {
+      std::cerr << "[ERROR]: Number of I/O streams must be positive"
+                << std::endl;
+      exit_with_help_message(argv);
+    }
+
+    if (restore && snapshot_dir.empty()) {
+      std::cerr << "[ERROR]: Restoring requires a snapshot directory"
+                << std::endl;
+      exit_with_help_message(argv);
+    }
+
     if (is_initiator) {
       if (index_dir.empty()) {
         std::cerr << "[ERROR]: Directory of partitioned index files must be "
@@ -88,6 +255,66 @@ private:
         exit_with_help_message(argv);
       }
 
+      if (distribution != str("static") && distribution != str("cost") &&
+          distribution != str("dynamic")) {
+        std::cerr << "[ERROR]: Invalid distribution" << std::endl;
+        exit_with_help_message(argv);
+      }
+
+      if (scheduling != str("fifo") && scheduling != str("priority") &&
+          scheduling != str("weighted") && scheduling != str("dedicated")) {
+        std::cerr << "[ERROR]: Invalid scheduling" << std::endl;
+        exit_with_help_message(argv);
+      }
+
+      if (scheduling == str("weighted") && read_weight == 0) {
+        std::cerr << "[ERROR]: Read weight must be positive" << std::endl;
+        exit_with_help_message(argv);
+      }
+
+      if (scheduling == str("dedicated") &&
+          (writer_threads == 0 || writer_threads >= num_threads)) {
+        std::cerr << "[ERROR]: Writer threads must be positive and fewer than "
+                     "the compute threads"
+                  << std::endl;
+        exit_with_help_message(argv);
+      }
+
+      if (chunk_size == 0) {
+        std::cerr << "[ERROR]: Chunk size must be positive" << std::endl;
+        exit_with_help_message(argv);
+      }
+
+      if (insert_batch == 0) {
+        std::cerr << "[ERROR]: Insert batch size must be positive" << std::endl;
+        exit_with_help_message(argv);
+      }
+
+      if (insert_pipeline == 0) {
+        std::cerr << "[ERROR]: Insert pipeline depth must be positive"
+                  << std::endl;
+        exit_with_help_message(argv);
+      }
+
+      if (insert_pipeline > 1 && insert_batch > 1) {
+        std::cerr << "[ERROR]: Batched inserts cannot be pipelined"
+                  << std::endl;
+        exit_with_help_message(argv);
+      }
+
+      if (own_terms && distribution == str("dynamic")) {
+        std::cerr << "[ERROR]: Term ownership requires static or cost "
+                     "distribution"
+                  << std::endl;
+        exit_with_help_message(argv);
+      }
+
+      if (merge_fill > 100) {
+        std::cerr << "[ERROR]: Merge fill must not exceed 100 percent"
+                  << std::endl;
+        exit_with_help_message(argv);
+      }
+
       if (block_size < 12) {
         std::cerr << "[ERROR]: Block size must be minimum 12 bytes"
                   << std::endl;
@@ -117,6 +344,69 @@ public:
          << (config.disable_thread_pinning ? "false" : "true") << std::endl;
       os << std::setw(width) << "block size: " << config.block_size
          << std::endl;
+      os << std::setw(width) << "distribution: " << config.distribution
+         << std::endl;
+      if (config.get_distribution() == Distribution::dynamic_dist) {
+        os << std::setw(width) << "chunk size: " << config.chunk_size
+           << std::endl;
+      }
+      os << std::setw(width) << "scheduling: " << config.scheduling
+         << std::endl;
+      if (config.get_scheduling() == Scheduling::weighted_sched) {
+        os << std::setw(width) << "read weight: " << config.read_weight
+           << std::endl;
+      }
+      if (config.get_scheduling() == Scheduling::dedicated_sched) {
+        os << std::setw(width) << "writer threads: " << config.writer_threads
+           << std::endl;
+      }
+      os << std::setw(width) << "queries grouped: "
+         << (config.group_queries ? "true" : "false") << std::endl;
+      os << std::setw(width) << "split threshold: " << config.split_threshold
+         << std::endl;
+      os << std::setw(width) << "insert batch size: " << config.insert_batch
+         << std::endl;
+      os << std::setw(width) << "insert pipeline depth: "
+         << config.insert_pipeline << std::endl;
+      os << std::setw(width) << "terms owned: "
+         << (config.own_terms ? "true" : "false") << std::endl;
+      os << std::setw(width) << "delta log entries: " << config.delta_entries
+         << std::endl;
+      os << std::setw(width) << "merge fill: " << config.merge_fill
+         << std::endl;
+      os << std::setw(width) << "cached blocks: " << config.cache_blocks
+         << std::endl;
+      os << std::setw(width) << "max backoff (ns): " << config.backoff_ns
+         << std::endl;
+      os << std::setw(width) << "lock lease (us): " << config.lock_lease_us
+         << std::endl;
+      os << std::setw(width) << "max terms: " << config.max_terms << std::endl;
+      os << std::setw(width) << "validations timed: "
+         << (config.time_validation ? "true" : "false") << std::endl;
+      if (!config.ingest_file.empty()) {
+        os << std::setw(width) << "ingest file: " << config.ingest_file
+           << std::endl;
+      }
+      if (!config.export_file.empty()) {
+        os << std::setw(width) << "export file: " << config.export_file
+           << std::endl;
+      }
+      os << std::setfill(filler) << std::setw(max_width) << "" << std::endl;
+    }
+    if (config.is_server) {
+      os << std::left << std::setfill(' ');
+      os << std::setw(width) << "pool blocks: " << config.pool_blocks
+         << std::endl;
+      os << std::setw(width) << "grow blocks: " << config.grow_blocks
+         << std::endl;
+      os << std::setw(width) << "I/O streams: " << config.io_streams
+         << std::endl;
+      if (!config.snapshot_dir.empty()) {
+        os << std::setw(width) << "snapshot directory: " << config.snapshot_dir
+           << std::endl;
+        os << std::setw(width) << "restored: "
+           << (config.restore ? "true" : "false") << std::endl;
+      }
       os << std::setfill(filler) << std::setw(max_width) << "" << std::endl;
     }
     return os;
@@ -6,6 +6,9 @@
 namespace inv_index {
 constexpr static u64 COMPUTE_NODE_MAX_MEMORY = 10ul * 1073741824ul;  // 10 GB
 constexpr static u32 MAX_QPS = 4;  // max number of QPs per compute node
+constexpr static u64 IO_ALIGNMENT = 4096;  // of O_DIRECT transfers
+constexpr static u64 IO_CHUNK = 64ul << 20;  // bytes per pread/pwrite
+constexpr static u32 IO_STREAMS = 4;  // parallel pread/pwrite streams
 
 namespace document_based {
 constexpr static u32 NUM_READ_BUFFERS = 2;
@@ -17,8 +20,26 @@ constexpr static u32 READ_BUFFER_LENGTH = 32;  // number of max query terms
 constexpr static u32 READ_BUFFER_DEPTH = 2;  // available blocks per query term
 constexpr static u32 CACHE_LINE_SIZE = 64;
 constexpr static u32 CACHE_LINE_ITEMS = CACHE_LINE_SIZE / sizeof(u32);
+#ifdef CRC_BLOCKS
+// dynamic blocks are validated by a CRC32C in their footer instead of
+// versioned cache lines: [ crc | crc'd entries | r_ptr (64) | flags (64) ]
+constexpr static bool CACHE_LINE_VERSIONS = false;
+constexpr static u32 DYNAMIC_FOOTER_SIZE = 24;
+#else
+constexpr static bool CACHE_LINE_VERSIONS = true;
 constexpr static u32 DYNAMIC_FOOTER_SIZE = 16;
+#endif
 constexpr static u32 FREELIST_PARTITIONS = 16;
+constexpr static u32 FREELIST_RUN_LENGTH = 32;  // blocks claimed at once
+constexpr static u32 FREELIST_WINDOW = 1024;  // next pointers READ at once
+constexpr static u32 MAX_SEGMENTS = 64;  // block pool segments per memory node
+constexpr static u32 DELTA_COUNTER_CHUNK = 8192;  // counters READ at once
+constexpr static u32 COMPACTION_INTERVAL_MS = 10;  // between compaction passes
+constexpr static u32 INGEST_WINDOW = 64;  // blocks of a bulk ingest in flight
+constexpr static u32 BLOCK_CACHE_SHARDS = 64;  // independently locked
+constexpr static u32 BACKOFF_BASE_NS = 100;  // backoff after the first retry
+constexpr static u32 CONTENTION_BUCKETS = 8;  // of the retry histograms
+constexpr static u32 RECLAIM_BATCH = 64;  // retired blocks freed at once
 }  // namespace block_based
 
 }  // namespace inv_index
@@ -0,0 +1,63 @@
+#ifndef INDEX_CRC32C_HH
+#define INDEX_CRC32C_HH
+
+#include <array>
+#include <cstring>
+#include <library/types.hh>
+
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
+// CRC32C (Castagnoli, reflected polynomial 0x82f63b78) with the crc32
+// instruction of SSE4.2 (compile with -msse4.2), otherwise with a lookup table
+// (both produce the same checksums, i.e., partitioned blocks stay valid)
+namespace crc32c_table {
+
+constexpr std::array<u32, 256> generate() {
+  std::array<u32, 256> table{};
+
+  for (u32 i = 0; i < 256; ++i) {
+    u32 crc = i;
+    for (u32 bit = 0; bit < 8; ++bit) {
+      crc = (crc >> 1) ^ ((crc & 1) ? 0x82f63b78u : 0);
+    }
+
+    table[i] = crc;
+  }
+
+  return table;
+}
+
+constexpr static std::array<u32, 256> table = generate();
+
+}  // namespace crc32c_table
+
+// continues the checksum crc (of preceding bytes) with num_bytes of data
+inline u32 crc32c(const void* data, u64 num_bytes, u32 crc = 0) {
+  const byte* s = static_cast<const byte*>(data);
+  crc = ~crc;
+
+#ifdef __SSE4_2__
+  u64 wide = crc;
+  for (; num_bytes >= sizeof(u64); num_bytes -= sizeof(u64)) {
+    u64 word;
+    std::memcpy(&word, s, sizeof(u64));
+    wide = _mm_crc32_u64(wide, word);
+    s += sizeof(u64);
+  }
+
+  crc = static_cast<u32>(wide);
+  for (; num_bytes > 0; --num_bytes) {
+    crc = _mm_crc32_u8(crc, *s++);
+  }
+#else
+  for (; num_bytes > 0; --num_bytes) {
+    crc = crc32c_table::table[(crc ^ *s++) & 0xff] ^ (crc >> 8);
+  }
+#endif
+
+  return ~crc;
+}
+
+#endif  // INDEX_CRC32C_HH
@@ -11,6 +11,7 @@
 #include "index/configuration.hh"
 #include "index/operations.hh"
 #include "index/query/query.hh"
+#include "index/query/query_stream.hh"
 #include "index/shared_context.hh"
 #include "remote_pointer.hh"
 
@@ -20,8 +21,8 @@ class DocumentBasedQueryHandler {
 public:
   using Configuration = configuration::IndexConfiguration;
   using ComputeThreads = vec<u_ptr<ComputeThread>>;
-  using SharedContext = SharedContext<ComputeThread>;
-  using Queue = concurrent_queue<u32>;
+  using SharedContext = ::SharedContext<ComputeThread>;
+  using Queue = query::QueryStream;
   inline static const str name = "document";
 
 private:
@@ -146,6 +147,17 @@ public:
 
   ComputeThreads& get_compute_threads() { return compute_threads_; }
 
+  // in entries (summed over all memory nodes)
+  u64 get_list_length(u32 term) const {
+    u64 length = 0;
+    for (const RemotePointers& remote_pointers : all_remote_pointers_) {
+      length +=
+        term < remote_pointers.size() ? remote_pointers[term].length : 0;
+    }
+
+    return length;
+  }
+
   void READ_row_into_buffer(query::Query& query,
                             u32 buffer_id,
                             u32 memory_node,
@@ -224,7 +236,7 @@ public:
     u32 q;  // idx to query
 
     // try pop queue
-    while (query_queue.try_dequeue(q)) {
+    while (query_queue.try_dequeue(q, thread_id)) {
       query::Query& query = queries[q];
       if (query.type != QueryType::READ) {
         continue;
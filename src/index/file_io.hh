@@ -0,0 +1,158 @@
+#ifndef INDEX_FILE_IO_HH
+#define INDEX_FILE_IO_HH
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <library/types.hh>
+#include <library/utils.hh>
+#include <thread>
+
+#include "constants.hh"
+
+namespace inv_index {
+
+// a file transferred in large chunks by parallel pread/pwrite streams, with
+// O_DIRECT if the file system supports it (unaligned remainders and file
+// systems without O_DIRECT, e.g., tmpfs, fall back to buffered I/O), the
+// streams may be pinned s.t. pages of a buffer are first touched by cores of
+// the NUMA node it is bound to (stream 0 is the calling thread)
+class File {
+public:
+  File(const str& path,
+       bool write,
+       u32 num_streams = IO_STREAMS,
+       const vec<u32>& stream_cores = {})
+      : path_(path),
+        num_streams_(std::max<u32>(num_streams, 1)),
+        stream_cores_(stream_cores) {
+    const int flags = write ? O_WRONLY | O_CREAT | O_TRUNC : O_RDONLY;
+
+    fd_ = open(path.c_str(), flags, 0644);
+    lib_assert(fd_ >= 0, "cannot open file \"" + path + "\"");
+    direct_fd_ = open(path.c_str(), (flags & ~O_TRUNC) | O_DIRECT, 0644);
+  }
+
+  ~File() {
+    if (direct_fd_ >= 0) {
+      close(direct_fd_);
+    }
+
+    close(fd_);
+  }
+
+  File(const File&) = delete;
+  File& operator=(const File&) = delete;
+
+  size_t get_size() const {
+    const off_t size = lseek(fd_, 0, SEEK_END);
+    lib_assert(size >= 0, "cannot determine the size of \"" + path_ + "\"");
+    return size;
+  }
+
+  void write(const void* data, size_t num_bytes, u64 offset) {
+    transfer(const_cast<byte*>(static_cast<const byte*>(data)),
+             num_bytes,
+             offset,
+             true);
+  }
+
+  void read(void* data, size_t num_bytes, u64 offset) {
+    transfer(static_cast<byte*>(data), num_bytes, offset, false);
+  }
+
+  // the written data is durable (including the file size)
+  void sync() const {
+    lib_assert(fsync(fd_) == 0, "cannot sync \"" + path_ + "\"");
+  }
+
+  // aligned offsets of the parts of a file (for O_DIRECT)
+  static u64 align(u64 offset) {
+    return (offset + IO_ALIGNMENT - 1) / IO_ALIGNMENT * IO_ALIGNMENT;
+  }
+
+  bool is_direct() const { return direct_fd_ >= 0; }
+
+private:
+  // the aligned prefix is split into chunks claimed by the streams
+  void transfer(byte* data, size_t num_bytes, u64 offset, bool write) {
+    const bool aligned = direct_fd_ >= 0 &&
+                         reinterpret_cast<u64>(data) % IO_ALIGNMENT == 0 &&
+                         offset % IO_ALIGNMENT == 0;
+    const size_t direct_bytes =
+      aligned ? num_bytes / IO_ALIGNMENT * IO_ALIGNMENT : 0;
+    const size_t num_chunks = (direct_bytes + IO_CHUNK - 1) / IO_CHUNK;
+
+    std::atomic<size_t> next_chunk{0};
+    const auto stream = [&](u32 s) {
+      if (s > 0 && !stream_cores_.empty()) {
+        pin_stream(stream_cores_[s % stream_cores_.size()]);
+      }
+
+      for (size_t c = next_chunk++; c < num_chunks; c = next_chunk++) {
+        const size_t begin = c * IO_CHUNK;
+        const size_t end = std::min<size_t>(begin + IO_CHUNK, direct_bytes);
+        transfer_range(
+          direct_fd_, data + begin, end - begin, offset + begin, write);
+      }
+    };
+
+    vec<std::thread> streams;
+    const u32 num_streams = std::min<size_t>(num_streams_, num_chunks);
+    for (u32 s = 1; s < num_streams; ++s) {
+      streams.emplace_back(stream, s);
+    }
+
+    stream(0);
+    for (auto& s : streams) {
+      s.join();
+    }
+
+    transfer_range(fd_,
+                   data + direct_bytes,
+                   num_bytes - direct_bytes,
+                   offset + direct_bytes,
+                   write);
+  }
+
+  static void pin_stream(u32 core) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(core, &cpuset);
+    lib_assert(
+      pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) == 0,
+      "cannot pin I/O stream to core " + std::to_string(core));
+  }
+
+  // pread and pwrite may transfer fewer bytes than requested
+  void transfer_range(
+    int fd, byte* data, size_t num_bytes, u64 offset, bool write) const {
+    while (num_bytes > 0) {
+      const ssize_t done = write ? pwrite(fd, data, num_bytes, offset)
+                                 : pread(fd, data, num_bytes, offset);
+      lib_assert(done > 0,
+                 "I/O of \"" + path_ + "\" failed: " + std::strerror(errno));
+
+      data += done;
+      offset += done;
+      num_bytes -= done;
+    }
+  }
+
+private:
+  const str path_;
+  const u32 num_streams_;
+  const vec<u32> stream_cores_;
+  int fd_{-1};
+  int direct_fd_{-1};
+};
+
+}  // namespace inv_index
+
+#endif  // INDEX_FILE_IO_HH
@@ -1,30 +1,48 @@
 #ifndef INDEX_MEMORY_NODE_HH
 #define INDEX_MEMORY_NODE_HH
 
-#include <fstream>
+#include <algorithm>
+#include <atomic>
 #include <library/connection_manager.hh>
 #include <library/detached_qp.hh>
 #include <library/hugepage.hh>
 #include <library/utils.hh>
 #include <timing/timing.hh>
 
+#include "block_based_dynamic/delta_layout.hh"
+#include "block_based_dynamic/segment_table.hh"
+#include "block_based_dynamic/snapshot.hh"
 #include "configuration.hh"
 #include "constants.hh"
 #include "core_assignment.hh"
+#include "file_io.hh"
 
 namespace inv_index {
 
 template <bool dynamic = false>
 class MemoryNode {
   using Configuration = configuration::IndexConfiguration;
-  using CoreAssignment = CoreAssignment<AssignmentPolicy::interleaved>;
+  using CoreAssignment = ::CoreAssignment<AssignmentPolicy::interleaved>;
+  using Segment = block_based::dynamic::Segment;
+  using SegmentTable = block_based::dynamic::SegmentTable;
+  using ControlMessage = block_based::dynamic::ControlMessage;
+  using ControlType = block_based::dynamic::ControlType;
+  using DeltaLayout = block_based::dynamic::DeltaLayout;
+  using Snapshot = block_based::dynamic::Snapshot;
 
 public:
   explicit MemoryNode(Configuration& config)
       : context_(config),
         cm_(context_, config),
         num_clients_(config.num_clients),
-        index_region_(context_) {
+        index_region_(context_),
+        pool_blocks_(config.pool_blocks),
+        grow_blocks_(config.grow_blocks),
+        table_region_(context_),
+        delta_region_(context_),
+        catalog_region_(context_),
+        snapshot_dir_(config.snapshot_dir),
+        io_streams_(config.io_streams) {
     auto t_read_index = timing_.create_enroll("read_index_into_memory");
     cm_.connect_to_clients();
 
@@ -32,6 +50,7 @@ public:
       const u32 core = core_assignment_.get_available_core();
       pin_main_thread(core);
       print_status("pinned main thread to core " + std::to_string(core));
+      set_io_cores();
     }
 
     // receive index location
@@ -44,12 +63,22 @@ public:
       std::cerr << "block size: " << block_size_ << std::endl;
     }
 
-    auto [file_stream, index_size] = open_index_file(index_file);
-    auto free_list_offset = allocate_memory(index_size);
+    size_t index_size;
+    std::optional<u32> free_list_offset;
+
+    if (dynamic && config.restore) {
+      std::tie(index_size, free_list_offset) =
+        restore_first_segment(Snapshot::get_path(snapshot_dir_, index_file));
 
-    t_read_index->start();
-    read_index_into_memory(file_stream, index_size);
-    t_read_index->stop();
+    } else {
+      File file(index_file, false, io_streams_, io_cores_);
+      index_size = file.get_size();
+      free_list_offset = allocate_memory(index_size);
+
+      t_read_index->start();
+      read_index_into_memory(file, index_size);
+      t_read_index->stop();
+    }
 
     // communicate index size, buffer size, and possibly free list offset
     vec<size_t> sizes = {index_size, index_buffer_.buffer_size};
@@ -78,6 +107,34 @@ public:
       context_.poll_send_cq_until_completion();
     }
 
+    if constexpr (dynamic) {
+      // the index buffer is the first segment of the block pool
+      segment_table_.segments[0] = {0, free_list_offset.value(), token};
+      segment_table_.num_segments = 1;
+      restore_segments();
+
+      table_region_.register_memory(
+        std::addressof(segment_table_), sizeof(SegmentTable), true);
+      MemoryRegionToken table_token = table_region_.createToken();
+
+      for (QP& qp : cm_.client_qps) {
+        qp->post_send_inlined(
+          std::addressof(table_token), sizeof(table_token), IBV_WR_SEND);
+        context_.poll_send_cq_until_completion();
+      }
+
+      allocate_delta_logs();
+      allocate_term_catalog();
+
+      if (snapshot_) {
+        report_throughput("snapshot read",
+                          snapshot_->get_transferred_bytes(),
+                          snapshot_->is_direct(),
+                          t_restore_);
+        snapshot_.reset();
+      }
+    }
+
     // connect for each compute thread a new QP
     print_status("connect QPs of compute threads");
     vec<u_ptr<DetachedQP>> qps;
@@ -96,13 +153,39 @@ public:
       }
     }
 
+    // compute threads may request growing the pool once we are ready
+    if constexpr (dynamic) {
+      post_control_receives(qps);
+    }
+
     // notify compute nodes that we are ready
     cm_.synchronize();
 
     // wait until we get notifications from all compute nodes to terminate
-    idle();
+    idle(qps);
+
+    if (dynamic && !snapshot_dir_.empty()) {
+      write_snapshot(Snapshot::get_path(snapshot_dir_, index_file), index_size);
+    }
+
     index_buffer_.deallocate();
 
+    if constexpr (dynamic) {
+      std::cerr << "block pool segments: " << segment_table_.num_segments
+                << std::endl;
+      for (auto& buffer : pool_buffers_) {
+        buffer->deallocate();
+      }
+
+      if (delta_buffer_.buffer_size > 0) {
+        delta_buffer_.deallocate();
+      }
+
+      if (catalog_buffer_.buffer_size > 0) {
+        catalog_buffer_.deallocate();
+      }
+    }
+
     std::cout << timing_ << std::endl;
   }
 
@@ -122,54 +205,61 @@ private:
     return index_file;
   }
 
-  std::pair<std::ifstream, size_t> open_index_file(const str& index_file) {
-    std::ifstream file(index_file, std::ios::binary);
-    lib_assert(file.good(), "file \"" + index_file + "\" does not exist");
-
-    file.unsetf(std::ios::skipws);  // w/out that we are missing data
-    size_t file_size;
-
-    // determine file size and set cursor back to the beginning
-    file.seekg(0, std::ios::end);
-    file_size = file.tellg();
-    file.seekg(0, std::ios::beg);
-
-    return {std::move(file), file_size};
+  // the I/O streams run on cores of the NIC's NUMA node (the first one on the
+  // core of the main thread) s.t. they first touch the index buffer there
+  void set_io_cores() {
+    ::CoreAssignment<AssignmentPolicy::strict> io_assignment;
+    for (u32 s = 0; s < io_streams_; ++s) {
+      io_cores_.push_back(io_assignment.get_available_core());
+    }
   }
 
   // head1 (64) | head2 (64) | ... | block0-next (32) | block1-next (32) | ...
-  void initialize_freelist(size_t num_index_blocks, size_t total_blocks) {
+  // block numbers are global, i.e., they continue over the pool segments,
+  // the upper half of a head counts its modifications (starting at zero)
+  void initialize_freelist(byte* segment,
+                           size_t first_block,
+                           size_t first_free_block,
+                           size_t num_blocks) {
     print_status("initialize free list");
-    lib_assert(total_blocks < static_cast<u32>(-1),
+    const size_t end_block = first_block + num_blocks;
+    lib_assert(end_block < static_cast<u32>(-1),
                "cannot address all blocks with 4B");
 
     const u64 begin_addr =
-      reinterpret_cast<u64>(index_buffer_.get_full_buffer()) +
-      total_blocks * block_size_;
+      reinterpret_cast<u64>(segment) + num_blocks * block_size_;
 
     // set up heads
     for (u32 i = 0; i < block_based::FREELIST_PARTITIONS; ++i) {
-      *(reinterpret_cast<u64*>(begin_addr) + i) = num_index_blocks + i;
+      const size_t head = first_free_block + i;
+      *(reinterpret_cast<u64*>(begin_addr) + i) =
+        head < end_block ? head : static_cast<u32>(-1);
     }
 
     u32* free_list_ptr = reinterpret_cast<u32*>(
       begin_addr + sizeof(u64) * block_based::FREELIST_PARTITIONS);
 
-    for (u32 i = 0; i < total_blocks; ++i) {
+    for (size_t i = first_block; i < end_block; ++i) {
       // those blocks are occupied
-      if (i < num_index_blocks) {
+      if (i < first_free_block) {
         *free_list_ptr++ = static_cast<u32>(-1);  // nullptr
 
       } else {
         // set next pointer to next block wrt the number of heads
-        u32 point_to = i + block_based::FREELIST_PARTITIONS;
-        point_to = point_to < total_blocks ? point_to : static_cast<u32>(-1);
+        size_t point_to = i + block_based::FREELIST_PARTITIONS;
+        point_to = point_to < end_block ? point_to : static_cast<u32>(-1);
 
         *free_list_ptr++ = point_to;
       }
     }
   }
 
+  size_t get_segment_size(size_t num_blocks) const {
+    return num_blocks * block_size_ +
+           block_based::FREELIST_PARTITIONS * sizeof(u64) +  // heads (each 8B)
+           num_blocks * sizeof(u32);
+  }
+
   std::optional<u32> allocate_memory(size_t index_size) {
     auto t_allocate = timing_.create_enroll("allocate_index_buffer");
     std::cerr << "index file size: " << index_size << std::endl;
@@ -181,24 +271,29 @@ private:
       std::cerr << "num index blocks: " << num_index_blocks << std::endl;
       const size_t available_memory = index_buffer_.get_memory_size();
 
-      const size_t additional_blocks = 1000000;  // TODO: for now
-      const size_t total_blocks = num_index_blocks + additional_blocks;
+      // without a configured pool size, the pool spans all huge pages
+      size_t pool_blocks = pool_blocks_;
+      if (pool_blocks == 0) {
+        const size_t index_blocks_size = get_segment_size(num_index_blocks);
+        lib_assert(index_blocks_size < available_memory,
+                   "block allocation failed");
+        pool_blocks = (available_memory - index_blocks_size) /
+                      (block_size_ + sizeof(u32));
+      }
+
+      const size_t total_blocks = num_index_blocks + pool_blocks;
       std::cerr << "num total blocks: " << total_blocks << std::endl;
 
-      const size_t free_list_size =
-        block_based::FREELIST_PARTITIONS * sizeof(u64) +  // heads (each 8B)
-        total_blocks * sizeof(u32);
-      const size_t allocation_size =
-        total_blocks * block_size_ + free_list_size;
+      const size_t allocation_size = get_segment_size(total_blocks);
       lib_assert(allocation_size <= available_memory,
                  "block allocation failed");
 
-      // pre-allocate all available huge pages
-      //      index_buffer_.allocate(index_buffer_.get_memory_size());
       index_buffer_.allocate(allocation_size);
       index_buffer_.touch_memory();
+      allocated_memory_ = allocation_size;
 
-      initialize_freelist(num_index_blocks, total_blocks);
+      initialize_freelist(
+        index_buffer_.get_full_buffer(), 0, num_index_blocks, total_blocks);
       free_list_offset = total_blocks;
     } else {
       // just allocate the size of index
@@ -209,17 +304,19 @@ private:
     return free_list_offset;
   }
 
-  void read_index_into_memory(std::ifstream& file_stream, size_t file_size) {
+  // parallel streams READ the file directly into the (registered) huge pages
+  void read_index_into_memory(File& file, size_t file_size) {
     print_status("read index into memory");
     auto t_read = timing_.create_enroll("read_file");
 
     t_read->start();
-    file_stream.read(reinterpret_cast<char*>(index_buffer_.get_full_buffer()),
-                     file_size);
+    file.read(index_buffer_.get_full_buffer(), file_size, 0);
     t_read->stop();
+
+    report_throughput("index read", file_size, file.is_direct(), t_read);
   }
 
-  void idle() {
+  void idle(vec<u_ptr<DetachedQP>>& qps) {
     print_status("idle");
 
     // dummy region
@@ -230,8 +327,303 @@ private:
       qp->post_receive(region);
     }
 
-    // wait
-    context_.receive(num_clients_);
+    if constexpr (dynamic) {
+      // serve control messages of compute threads until all are done
+      ibv_wc wc{};
+      u32 done_clients = 0;
+
+      while (done_clients < num_clients_) {
+        done_clients += context_.poll_recv_cq(&wc, 1);
+
+        for (u32 i = 0; i < qps.size(); ++i) {
+          if (qps[i]->poll_recv_cq(&wc, 1) > 0) {
+            handle_control_message(qps[i], i);
+          }
+        }
+      }
+
+    } else {
+      // wait
+      context_.receive(num_clients_);
+    }
+  }
+
+  void post_control_receive(u_ptr<DetachedQP>& qp, u32 idx) {
+    qp->qp->post_receive(*control_region_,
+                         sizeof(ControlMessage),
+                         idx,
+                         idx * sizeof(ControlMessage));
+  }
+
+  // one control message per compute thread QP
+  void post_control_receives(vec<u_ptr<DetachedQP>>& qps) {
+    control_messages_.resize(qps.size());
+    control_region_ = std::make_unique<LocalMemoryRegion>(
+      context_,
+      control_messages_.data(),
+      control_messages_.size() * sizeof(ControlMessage));
+
+    for (u32 i = 0; i < qps.size(); ++i) {
+      post_control_receive(qps[i], i);
+    }
+  }
+
+  void handle_control_message(u_ptr<DetachedQP>& qp, u32 idx) {
+    const ControlMessage message = control_messages_[idx];
+    lib_assert(message.type == ControlType::GROW, "unknown control message");
+    post_control_receive(qp, idx);
+
+    // the requester might just not know the latest segment yet
+    u32 num_segments = segment_table_.num_segments;
+    if (message.known_segments == num_segments) {
+      num_segments = grow_pool();
+    }
+
+    qp->qp->post_send_inlined(
+      std::addressof(num_segments), sizeof(u32), IBV_WR_SEND);
+
+    ibv_wc wc{};
+    while (qp->poll_send_cq(&wc, 1) == 0) {
+      // wait
+    }
+  }
+
+  // the initiator sends the layout once it knows the universe size, the
+  // logs are only allocated if they are enabled (capacity > 0)
+  void allocate_delta_logs() {
+    print_status("receive delta log layout");
+    const u32 capacity = cm_.initiator_qp->receive_u32(context_);
+    const u32 num_terms = cm_.initiator_qp->receive_u32(context_);
+
+    const DeltaLayout layout{capacity, num_terms};
+    const size_t delta_size = capacity > 0 ? layout.get_size() : 0;
+    lib_assert(!snapshot_ || snapshot_->header.delta_size == delta_size,
+               "delta log layout differs from the snapshot");
+
+    if (capacity == 0) {
+      return;
+    }
+
+    std::cerr << "delta logs size: " << layout.get_size() << std::endl;
+    lib_assert(
+      allocated_memory_ + layout.get_size() <= index_buffer_.get_memory_size(),
+      "delta log allocation failed");
+
+    delta_buffer_.allocate(layout.get_size());
+    allocated_memory_ += layout.get_size();
+
+    if (snapshot_) {
+      t_restore_->start();
+      snapshot_->read_part(delta_buffer_.get_full_buffer(), delta_size);
+      t_restore_->stop();
+    } else {
+      delta_buffer_.touch_memory();
+      layout.initialize(delta_buffer_.get_full_buffer());
+    }
+
+    delta_region_.register_memory(
+      delta_buffer_.get_full_buffer(), layout.get_size(), true);
+    MemoryRegionToken delta_token = delta_region_.createToken();
+
+    for (QP& qp : cm_.client_qps) {
+      qp->post_send_inlined(
+        std::addressof(delta_token), sizeof(delta_token), IBV_WR_SEND);
+      context_.poll_send_cq_until_completion();
+    }
+  }
+
+  // entries of the remote term catalog (the encoded head pointers of new
+  // terms), only allocated if new terms are enabled (num_entries > 0)
+  void allocate_term_catalog() {
+    print_status("receive term catalog size");
+    const u32 num_entries = cm_.initiator_qp->receive_u32(context_);
+
+    const size_t catalog_size = static_cast<size_t>(num_entries) * sizeof(u64);
+    lib_assert(!snapshot_ || snapshot_->header.catalog_size == catalog_size,
+               "term catalog size differs from the snapshot");
+
+    if (num_entries == 0) {
+      return;
+    }
+
+    std::cerr << "term catalog size: " << catalog_size << std::endl;
+    lib_assert(
+      allocated_memory_ + catalog_size <= index_buffer_.get_memory_size(),
+      "term catalog allocation failed");
+
+    catalog_buffer_.allocate(catalog_size);
+    allocated_memory_ += catalog_size;
+
+    if (snapshot_) {
+      t_restore_->start();
+      snapshot_->read_part(catalog_buffer_.get_full_buffer(), catalog_size);
+      t_restore_->stop();
+    } else {
+      // zero entries denote terms without a head
+      catalog_buffer_.touch_memory();
+      std::fill_n(catalog_buffer_.get_full_buffer(), catalog_size, 0);
+    }
+
+    catalog_region_.register_memory(
+      catalog_buffer_.get_full_buffer(), catalog_size, true);
+    MemoryRegionToken catalog_token = catalog_region_.createToken();
+
+    for (QP& qp : cm_.client_qps) {
+      qp->post_send_inlined(
+        std::addressof(catalog_token), sizeof(catalog_token), IBV_WR_SEND);
+      context_.poll_send_cq_until_completion();
+    }
+  }
+
+  // allocates, registers, and publishes a new segment of the block pool,
+  // returns the number of segments
+  u32 grow_pool() {
+    u64& num_segments = segment_table_.num_segments;
+    const Segment& last = segment_table_.segments[num_segments - 1];
+    const size_t first_block = last.get_free_list_offset();
+    const size_t segment_size = get_segment_size(grow_blocks_);
+
+    if (grow_blocks_ == 0 || num_segments == block_based::MAX_SEGMENTS ||
+        first_block + grow_blocks_ >= static_cast<u32>(-1) ||
+        allocated_memory_ + segment_size > index_buffer_.get_memory_size()) {
+      print_status("cannot grow block pool");
+      return num_segments;
+    }
+
+    print_status("grow block pool");
+    add_segment(first_block, grow_blocks_, [&](HugePage<byte>& segment) {
+      segment.touch_memory();
+      initialize_freelist(
+        segment.get_full_buffer(), first_block, first_block, grow_blocks_);
+    });
+
+    return num_segments;
+  }
+
+  // allocates, initializes, registers, and publishes a pool segment
+  void add_segment(size_t first_block,
+                   size_t num_blocks,
+                   const func<void(HugePage<byte>&)>& initialize) {
+    u64& num_segments = segment_table_.num_segments;
+    const size_t segment_size = get_segment_size(num_blocks);
+
+    auto& buffer =
+      pool_buffers_.emplace_back(std::make_unique<HugePage<byte>>());
+    buffer->allocate(segment_size);
+    allocated_memory_ += segment_size;
+    initialize(*buffer);
+
+    auto& region =
+      pool_regions_.emplace_back(std::make_unique<MemoryRegion>(context_));
+    region->register_memory(buffer->get_full_buffer(), segment_size, true);
+
+    // shift the address s.t. global block numbers can be used as offsets
+    MemoryRegionToken token = region->createToken();
+    token.address -= first_block * block_size_;
+
+    // publish the entry before the number of segments
+    segment_table_.segments[num_segments] = {first_block, num_blocks, token};
+    std::atomic_thread_fence(std::memory_order_release);
+    ++num_segments;
+  }
+
+  // the index buffer (the first segment) is READ from the snapshot instead of
+  // the index file, returns the original index size and the free list offset
+  std::pair<size_t, u32> restore_first_segment(const str& path) {
+    print_status("restore snapshot " + path);
+    t_restore_ = timing_.create_enroll("read_snapshot");
+    snapshot_ =
+      std::make_unique<Snapshot>(path, false, io_streams_, io_cores_);
+    const auto& header = snapshot_->header;
+
+    lib_assert(header.block_size == block_size_,
+               "block size differs from the snapshot");
+    const size_t num_blocks = header.num_blocks[0];
+    const size_t allocation_size = get_segment_size(num_blocks);
+    lib_assert(allocation_size <= index_buffer_.get_memory_size(),
+               "block allocation failed");
+
+    index_buffer_.allocate(allocation_size);
+    allocated_memory_ = allocation_size;
+
+    t_restore_->start();
+    snapshot_->read_part(index_buffer_.get_full_buffer(), allocation_size);
+    t_restore_->stop();
+
+    return {header.index_size, num_blocks};
+  }
+
+  // the segments the pool has grown by before the snapshot
+  void restore_segments() {
+    if (!snapshot_) {
+      return;
+    }
+
+    const auto& header = snapshot_->header;
+    for (u64 s = 1; s < header.num_segments; ++s) {
+      add_segment(header.first_blocks[s],
+                  header.num_blocks[s],
+                  [&](HugePage<byte>& segment) {
+                    t_restore_->start();
+                    snapshot_->read_part(segment.get_full_buffer(),
+                                         segment.buffer_size);
+                    t_restore_->stop();
+                  });
+    }
+  }
+
+  // all compute nodes are done, i.e., no block is locked or in flight
+  void write_snapshot(const str& path, size_t index_size) {
+    print_status("write snapshot " + path);
+    auto t_write = timing_.create_enroll("write_snapshot");
+    t_write->start();
+
+    Snapshot snapshot(path, true, io_streams_, io_cores_);
+    auto& header = snapshot.header;
+    header.block_size = block_size_;
+    header.index_size = index_size;
+    header.num_segments = segment_table_.num_segments;
+
+    for (u64 s = 0; s < segment_table_.num_segments; ++s) {
+      const Segment& segment = segment_table_.segments[s];
+      header.first_blocks[s] = segment.first_block;
+      header.num_blocks[s] = segment.num_blocks;
+
+      const byte* buffer = s == 0 ? index_buffer_.get_full_buffer()
+                                  : pool_buffers_[s - 1]->get_full_buffer();
+      snapshot.write_part(buffer, get_segment_size(segment.num_blocks));
+    }
+
+    header.delta_size = delta_buffer_.buffer_size;
+    if (header.delta_size > 0) {
+      snapshot.write_part(delta_buffer_.get_full_buffer(), header.delta_size);
+    }
+
+    header.catalog_size = catalog_buffer_.buffer_size;
+    if (header.catalog_size > 0) {
+      snapshot.write_part(catalog_buffer_.get_full_buffer(),
+                          header.catalog_size);
+    }
+
+    snapshot.commit();
+    t_write->stop();
+
+    report_throughput("snapshot written",
+                      snapshot.get_transferred_bytes(),
+                      snapshot.is_direct(),
+                      t_write);
+  }
+
+  static void report_throughput(const str& action,
+                                u64 bytes,
+                                bool direct,
+                                const timing::Timing::IntervalPtr& t) {
+    const f64 gb = bytes / 1e9;
+    const f64 seconds = t->get_ms() / 1000.0;
+
+    std::cerr << action << ": " << gb << " GB in " << seconds
+              << " s (" << gb / std::max(seconds, 1e-9) << " GB/s"
+              << (direct ? ", O_DIRECT" : "") << ")" << std::endl;
   }
 
 private:
@@ -246,6 +638,35 @@ private:
   MemoryRegion index_region_;
   timing::Timing timing_;
   u32 block_size_;
+
+  // growable block pool (only dynamic)
+  const u32 pool_blocks_;
+  const u32 grow_blocks_;
+  size_t allocated_memory_{0};
+  SegmentTable segment_table_{};
+  MemoryRegion table_region_;
+  vec<u_ptr<HugePage<byte>>> pool_buffers_;
+  MemoryRegions pool_regions_;
+
+  // per-term delta logs (only dynamic)
+  HugePage<byte> delta_buffer_;
+  MemoryRegion delta_region_;
+
+  // remote term catalog (only dynamic with new terms)
+  HugePage<byte> catalog_buffer_;
+  MemoryRegion catalog_region_;
+
+  vec<ControlMessage> control_messages_;
+  u_ptr<LocalMemoryRegion> control_region_;
+
+  // snapshot of the blocks, delta logs, and term catalog (only dynamic)
+  const str snapshot_dir_;
+  u_ptr<Snapshot> snapshot_;  // only while restoring
+  timing::Timing::IntervalPtr t_restore_;
+
+  // streams of index file and snapshot transfers
+  const u32 io_streams_;
+  vec<u32> io_cores_;  // empty w/out thread pinning
 };
 
 }  // namespace inv_index
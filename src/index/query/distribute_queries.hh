@@ -3,8 +3,13 @@
 
 #include <library/queue_pair.hh>
 #include <library/utils.hh>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <queue>
 
 #include "query.hh"
+#include "term_owners.hh"
 
 namespace query {
 using Batch = vec<u32>;
@@ -30,15 +35,121 @@ void parse_batch(Batch& batch, Queries& queries) {
   }
 }
 
+using ListLength = func<u64(Key)>;
+using Assignment = vec<u32>;  // query idx -> client id
+
+// summed list lengths, for intersections the shortest list bounds the work
+u64 estimate_cost(const Query& q,
+                  const ListLength& list_length,
+                  bool intersection) {
+  u64 sum = 0;
+  u64 min = std::numeric_limits<u64>::max();
+
+  for (const Key key : q.keys) {
+    const u64 length = list_length(key);
+    sum += length;
+    min = std::min(min, length);
+  }
+
+  if (q.type == QueryType::READ && intersection && !q.keys.empty()) {
+    return min * q.size();
+  }
+
+  return sum;
+}
+
+Assignment assign_by_id(const Queries& queries, u32 num_total_clients) {
+  Assignment assignment(queries.size());
+
+  for (size_t idx = 0; idx < queries.size(); ++idx) {
+    assignment[idx] = queries[idx].id % num_total_clients;
+  }
+
+  return assignment;
+}
+
+// longest processing time first: the most expensive remaining query goes to
+// the compute node with the least predicted cost
+Assignment assign_by_cost(const Queries& queries,
+                          u32 num_total_clients,
+                          const vec<u64>& costs) {
+  Assignment assignment(queries.size());
+  vec<u32> order(queries.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](u32 a, u32 b) {
+    return costs[a] > costs[b];
+  });
+
+  using Load = std::pair<u64, u32>;  // predicted cost, client id
+  std::priority_queue<Load, vec<Load>, std::greater<>> loads;
+  for (u32 client_id = 0; client_id < num_total_clients; ++client_id) {
+    loads.emplace(0, client_id);
+  }
+
+  for (const u32 idx : order) {
+    auto [load, client_id] = loads.top();
+    loads.pop();
+
+    assignment[idx] = client_id;
+    loads.emplace(load + costs[idx], client_id);
+  }
+
+  return assignment;
+}
+
+vec<u64> predicted_costs(const Assignment& assignment,
+                         const vec<u64>& costs,
+                         u32 num_total_clients) {
+  vec<u64> node_costs(num_total_clients, 0);
+
+  for (size_t idx = 0; idx < assignment.size(); ++idx) {
+    node_costs[assignment[idx]] += costs[idx];
+  }
+
+  return node_costs;
+}
+
+// writes are sent to the compute nodes owning their terms, a write query is
+// split into one part per owning node (reads keep their assignment)
+void route_updates(Queries& queries,
+                   Assignment& assignment,
+                   const TermOwners& owners) {
+  const size_t num_queries = queries.size();
+
+  for (size_t idx = 0; idx < num_queries; ++idx) {
+    if (queries[idx].type == QueryType::READ || queries[idx].keys.empty()) {
+      continue;
+    }
+
+    std::map<u32, Keys> parts;  // node -> keys
+    for (const Key key : queries[idx].keys) {
+      parts[owners.get_node(key)].push_back(key);
+    }
+
+    // the query itself becomes the first part
+    auto part = parts.begin();
+    assignment[idx] = part->first;
+    queries[idx].keys = std::move(part->second);
+
+    for (++part; part != parts.end(); ++part) {
+      const Query& q = queries[idx];
+      queries.emplace_back(q.id, q.type, q.update_id, std::move(part->second));
+      assignment.push_back(part->first);
+    }
+  }
+}
+
 void distribute_queries(Queries& queries,
                         Context& context,
                         QPs& client_qps,
-                        u32 num_total_clients) {
+                        u32 num_total_clients,
+                        const Assignment& assignment) {
   print_status("distribute queries");
   Batches batches(num_total_clients, {0});
 
-  for (query::Query& q : queries) {
-    u32 client_id = q.id % num_total_clients;
+  for (size_t idx = 0; idx < queries.size(); ++idx) {
+    query::Query& q = queries[idx];
+    u32 client_id = assignment[idx];
 
     auto& batch = batches[client_id];
     ++batch[0];  // increase number of queries
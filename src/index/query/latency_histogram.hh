@@ -0,0 +1,76 @@
+#ifndef INDEX_QUERY_LATENCY_HISTOGRAM_HH
+#define INDEX_QUERY_LATENCY_HISTOGRAM_HH
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <library/types.hh>
+
+namespace query {
+
+// latencies (in ns) in log-linear buckets: values below SUB_BUCKETS have a
+// bucket of their own, every larger power of two is split into SUB_BUCKETS
+// buckets (i.e., percentiles are overestimated by less than 1 / SUB_BUCKETS),
+// values beyond MAX_BITS are clamped
+struct LatencyHistogram {
+  static constexpr u32 SUB_BITS = 3;
+  static constexpr u32 SUB_BUCKETS = 1u << SUB_BITS;
+  static constexpr u32 MAX_BITS = 40;  // about 18 minutes
+  static constexpr u32 NUM_BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+  std::array<u64, NUM_BUCKETS> buckets{};
+
+  void add(u64 latency_ns) { ++buckets[get_bucket(latency_ns)]; }
+
+  static u32 get_bucket(u64 value) {
+    value = std::min<u64>(value, (1ull << MAX_BITS) - 1);
+    if (value < SUB_BUCKETS) {
+      return value;
+    }
+
+    const u32 exponent = 63 - __builtin_clzll(value);
+    const u32 sub = (value >> (exponent - SUB_BITS)) - SUB_BUCKETS;
+    return (exponent - SUB_BITS + 1) * SUB_BUCKETS + sub;
+  }
+
+  // largest value of a bucket
+  static u64 get_upper_bound(u32 bucket) {
+    if (bucket < SUB_BUCKETS) {
+      return bucket;
+    }
+
+    const u32 shift = bucket / SUB_BUCKETS - 1;
+    const u64 lower = static_cast<u64>(SUB_BUCKETS + bucket % SUB_BUCKETS)
+                      << shift;
+    return lower + (1ull << shift) - 1;
+  }
+
+  // upper bound of the bucket holding the given percentile (in [0, 1]) of
+  // the counts, 0 if there are none
+  template <typename Counts>
+  static u64 get_percentile(const Counts& counts, f64 percentile) {
+    u64 total = 0;
+    for (u32 b = 0; b < NUM_BUCKETS; ++b) {
+      total += counts[b];
+    }
+
+    if (total == 0) {
+      return 0;
+    }
+
+    const u64 rank = std::max<u64>(std::ceil(percentile * total), 1);
+    u64 seen = 0;
+    for (u32 b = 0; b < NUM_BUCKETS; ++b) {
+      seen += counts[b];
+      if (seen >= rank) {
+        return get_upper_bound(b);
+      }
+    }
+
+    return get_upper_bound(NUM_BUCKETS - 1);
+  }
+};
+
+}  // namespace query
+
+#endif  // INDEX_QUERY_LATENCY_HISTOGRAM_HH
@@ -0,0 +1,431 @@
+#ifndef INDEX_QUERY_STREAM_HH
+#define INDEX_QUERY_STREAM_HH
+
+#include <chrono>
+#include <library/context.hh>
+#include <library/memory_region.hh>
+#include <library/queue_pair.hh>
+#include <library/utils.hh>
+#include <mutex>
+
+#include "distribute_queries.hh"
+#include "latency_histogram.hh"
+#include "query.hh"
+#include "timing/timing.hh"
+
+namespace query {
+
+// Hands out indices to the queries of a compute node.
+// Every compute thread has its own queue from which it dequeues batches of
+// indices, and steals batches from the other threads if its queue runs dry.
+// With static distribution, all indices are assigned upfront (optionally
+// grouped by term s.t. queries sharing a term are handled by the same thread).
+// With dynamic distribution, the global query stream stays on the initiator:
+// compute nodes claim chunks of it with an RDMA FAA on a shared counter and
+// READ the claimed chunk once there is no local work left.
+// Writes can be queued separately from reads s.t. reads are not delayed by
+// batches of long inserts (see separate_writes).
+// The latency of a query is measured from the dequeue of its batch until the
+// thread dequeues its next query.
+class QueryStream {
+  using Queue = concurrent_queue<u32>;  // idx to query
+  using Clock = std::chrono::steady_clock;
+  static constexpr u32 BATCH_SIZE = 16;
+
+  struct Worker {
+    Queue queue;   // all queries, or only reads if writes are separated
+    Queue writes;  // only if writes are separated
+    moodycamel::ConsumerToken token{queue};
+    moodycamel::ConsumerToken write_token{writes};
+
+    u32 batch[BATCH_SIZE]{};
+    size_t batch_size{0};
+    size_t pos{0};
+    u32 read_batches{0};  // since the last batch of writes
+
+    u64 bulk_dequeues{0};
+    u64 steals{0};
+    timing::Timing::IntervalPtr t_dequeue =
+      std::make_shared<timing::Timing::Interval>("dequeue");
+
+    // the query dequeued last is completed by the next dequeue
+    bool pending{false};
+    bool pending_write{false};
+    Clock::time_point batch_start;
+    LatencyHistogram read_latencies;
+    LatencyHistogram write_latencies;
+  };
+
+  struct StreamInfo {
+    u32 num_queries;
+    u32 num_chunks;
+    u32 chunk_size;
+    u32 max_chunk_length;  // in u32
+  };
+
+public:
+  void init(u32 num_threads) {
+    workers_.reserve(num_threads);
+    for (u32 thread_id = 0; thread_id < num_threads; ++thread_id) {
+      workers_.emplace_back(std::make_unique<Worker>());
+    }
+  }
+
+  // reads and writes (inserts and deletes) are dequeued from separate
+  // queues: the first writer_threads threads only dequeue writes (and the
+  // others only reads), without writer threads a thread dequeues read_weight
+  // batches of reads per batch of writes (0 prioritizes reads strictly)
+  void separate_writes(u32 read_weight, u32 writer_threads) {
+    separate_writes_ = true;
+    read_weight_ = read_weight;
+    writer_threads_ = writer_threads;
+  }
+
+  // distributes all local queries to the threads (in batches or by term)
+  void assign(Queries& queries, bool group_by_term) {
+    const u32 num_threads = workers_.size();
+    queries_ = &queries;
+
+    for (u32 idx = 0; idx < queries.size(); ++idx) {
+      const Query& q = queries[idx];
+      const u32 thread_id = group_by_term && !q.keys.empty()
+                              ? q.keys.front() % num_threads
+                              : (idx / BATCH_SIZE) % num_threads;
+
+      enqueue(*workers_[thread_id], idx, q.type);
+    }
+  }
+
+  bool try_dequeue(u32& idx, u32 thread_id) {
+    Worker& worker = *workers_[thread_id];
+
+    if (worker.pending) {
+      const auto latency = Clock::now() - worker.batch_start;
+      (worker.pending_write ? worker.write_latencies : worker.read_latencies)
+        .add(std::chrono::duration_cast<std::chrono::nanoseconds>(latency)
+               .count());
+      worker.pending = false;
+    }
+
+    if (worker.pos == worker.batch_size) {
+      worker.t_dequeue->start();
+      const bool found = refill_batch(worker, thread_id);
+      worker.t_dequeue->stop();
+
+      if (!found) {
+        return false;
+      }
+
+      worker.batch_start = Clock::now();
+    }
+
+    idx = worker.batch[worker.pos++];
+    worker.pending = true;
+    worker.pending_write = is_write((*queries_)[idx].type);
+    return true;
+  }
+
+  // initiator: serialize the queries in chunks and publish the stream
+  void publish(Queries& queries,
+               Context& context,
+               QPs& client_qps,
+               u32 chunk_size) {
+    print_status("publish query stream");
+    dynamic_ = true;
+    context_ = &context;
+    queries_ = &queries;
+
+    info_.num_queries = queries.size();
+    info_.num_chunks = (queries.size() + chunk_size - 1) / chunk_size;
+    info_.chunk_size = chunk_size;
+
+    // counter (64b) | chunk0 | chunk1 | ...
+    stream_ = {0, 0};
+    for (u32 chunk = 0; chunk < info_.num_chunks; ++chunk) {
+      const size_t chunk_begin = stream_.size();
+      directory_.push_back(chunk_begin);
+      stream_.push_back(0);
+
+      for (u32 idx = chunk * chunk_size;
+           idx < std::min<u32>((chunk + 1) * chunk_size, queries.size());
+           ++idx) {
+        Query& q = queries[idx];
+        ++stream_[chunk_begin];  // increase number of queries
+
+        stream_.insert(stream_.end(),
+                       {q.id,
+                        static_cast<u32>(q.type),
+                        q.update_id,
+                        static_cast<u32>(q.size())});
+        stream_.insert(stream_.end(), q.keys.begin(), q.keys.end());
+      }
+
+      info_.max_chunk_length = std::max<u32>(info_.max_chunk_length,
+                                             stream_.size() - chunk_begin);
+    }
+    directory_.push_back(stream_.size());
+
+    stream_region_ = std::make_unique<MemoryRegion>(context);
+    stream_region_->register_memory(
+      stream_.data(), stream_.size() * sizeof(u32), true);
+    token_ = stream_region_->createToken();
+
+    for (QP& qp : client_qps) {
+      qp->post_send_inlined(
+        std::addressof(info_), sizeof(StreamInfo), IBV_WR_SEND, false);
+      qp->post_send_inlined(
+        std::addressof(token_), sizeof(MemoryRegionToken), IBV_WR_SEND, false);
+
+      LocalMemoryRegion region{
+        context, directory_.data(), directory_.size() * sizeof(u64)};
+      qp->post_send(region, IBV_WR_SEND);
+      context.poll_send_cq_until_completion();
+    }
+
+    // the initiator claims its chunks through a loopback connection
+    loopback_qp_ = std::make_unique<QueuePair>(&context);
+    loopback_peer_ = std::make_unique<QueuePair>(&context);
+    loopback_qp_->transition_to_rtr(
+      {context.get_lid(), loopback_peer_->get_qp_num()});
+    loopback_qp_->transition_to_rts();
+    loopback_peer_->transition_to_rtr(
+      {context.get_lid(), loopback_qp_->get_qp_num()});
+    loopback_peer_->transition_to_rts();
+    qp_ = loopback_qp_.get();
+
+    register_fetch_buffer();
+  }
+
+  // non-initiators: receive the stream description, queries are claimed lazily
+  void subscribe(Queries& queries, Context& context, QP& initiator_qp) {
+    print_status("subscribe to query stream");
+    dynamic_ = true;
+    context_ = &context;
+    queries_ = &queries;
+    qp_ = initiator_qp.get();
+
+    LocalMemoryRegion info_region{
+      context, std::addressof(info_), sizeof(StreamInfo)};
+    initiator_qp->post_receive(info_region);
+    context.receive();
+
+    LocalMemoryRegion token_region{
+      context, std::addressof(token_), sizeof(MemoryRegionToken)};
+    initiator_qp->post_receive(token_region);
+    context.receive();
+
+    directory_.resize(info_.num_chunks + 1);
+    LocalMemoryRegion directory_region{
+      context, directory_.data(), directory_.size() * sizeof(u64)};
+    initiator_qp->post_receive(directory_region);
+    context.receive();
+
+    // queries are stored at their global id
+    queries.reserve(info_.num_queries);
+    for (u32 idx = 0; idx < info_.num_queries; ++idx) {
+      queries.emplace_back(idx, QueryType::READ, 0, Keys{});
+    }
+
+    chunk_buffer_.resize(info_.max_chunk_length);
+    chunk_region_ = std::make_unique<LocalMemoryRegion>(
+      context, chunk_buffer_.data(), chunk_buffer_.size() * sizeof(u32));
+
+    register_fetch_buffer();
+  }
+
+  u32 get_claimed_chunks() const { return claimed_chunks_; }
+  u64 get_bulk_dequeues(u32 thread_id) const {
+    return workers_[thread_id]->bulk_dequeues;
+  }
+  u64 get_steals(u32 thread_id) const { return workers_[thread_id]->steals; }
+  f64 get_dequeue_ms(u32 thread_id) const {
+    return workers_[thread_id]->t_dequeue->get_ms();
+  }
+  const LatencyHistogram& get_read_latencies(u32 thread_id) const {
+    return workers_[thread_id]->read_latencies;
+  }
+  const LatencyHistogram& get_write_latencies(u32 thread_id) const {
+    return workers_[thread_id]->write_latencies;
+  }
+
+private:
+  static bool is_write(QueryType type) {
+    return type == QueryType::INSERT || type == QueryType::DELETE;
+  }
+
+  void enqueue(Worker& worker, u32 idx, QueryType type) {
+    (separate_writes_ && is_write(type) ? worker.writes : worker.queue)
+      .enqueue(idx);
+  }
+
+  // dedicated threads either dequeue reads or writes
+  bool dequeues_reads(u32 thread_id) const {
+    return writer_threads_ == 0 || thread_id >= writer_threads_;
+  }
+  bool dequeues_writes(u32 thread_id) const {
+    return separate_writes_ &&
+           (writer_threads_ == 0 || thread_id < writer_threads_);
+  }
+
+  bool refill_batch(Worker& worker, u32 thread_id) {
+    worker.pos = 0;
+
+    // a thread with both reads and writes takes writes first once it has
+    // taken read_weight batches of reads
+    const bool writes_first =
+      !dequeues_reads(thread_id) ||
+      (dequeues_writes(thread_id) && read_weight_ > 0 &&
+       worker.read_batches >= read_weight_);
+
+    while (true) {
+      if (take_batch(worker, thread_id, writes_first) ||
+          (dequeues_reads(thread_id) && dequeues_writes(thread_id) &&
+           take_batch(worker, thread_id, !writes_first))) {
+        return true;
+      }
+
+      if (!dynamic_ || !claim_chunk(worker, thread_id)) {
+        return false;
+      }
+    }
+  }
+
+  // dequeues a batch of reads or writes from the own queue, or steals it
+  bool take_batch(Worker& worker, u32 thread_id, bool writes) {
+    worker.batch_size =
+      writes ? worker.writes.try_dequeue_bulk(
+                 worker.write_token, worker.batch, BATCH_SIZE)
+             : worker.queue.try_dequeue_bulk(
+                 worker.token, worker.batch, BATCH_SIZE);
+
+    if (worker.batch_size > 0) {
+      ++worker.bulk_dequeues;
+    } else if (!steal(worker, thread_id, writes)) {
+      return false;
+    }
+
+    worker.read_batches = writes ? 0 : worker.read_batches + 1;
+    return true;
+  }
+
+  // takes (at most) half a batch from the first thread that has work left
+  bool steal(Worker& worker, u32 thread_id, bool writes) {
+    const u32 num_threads = workers_.size();
+
+    for (u32 i = 1; i < num_threads; ++i) {
+      Worker& victim = *workers_[(thread_id + i) % num_threads];
+      worker.batch_size =
+        (writes ? victim.writes : victim.queue)
+          .try_dequeue_bulk(worker.batch, BATCH_SIZE / 2);
+
+      if (worker.batch_size > 0) {
+        ++worker.steals;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  void register_fetch_buffer() {
+    fetch_region_ = std::make_unique<LocalMemoryRegion>(
+      *context_, std::addressof(fetched_), sizeof(u64));
+  }
+
+  // claims the next chunk of the global stream and enqueues it to the
+  // claiming thread, returns false if the stream is exhausted
+  bool claim_chunk(Worker& worker, u32 thread_id) {
+    std::lock_guard<std::mutex> lock(refill_mutex_);
+
+    // another thread has claimed a chunk (with queries of this thread) in the
+    // meantime
+    for (auto& w : workers_) {
+      if ((dequeues_reads(thread_id) && w->queue.size_approx() > 0) ||
+          (dequeues_writes(thread_id) && w->writes.size_approx() > 0)) {
+        return true;
+      }
+    }
+
+    if (exhausted_) {
+      return false;
+    }
+
+    qp_->post_FAA(*fetch_region_, std::addressof(token_), 0, 1);
+    context_->poll_send_cq_until_completion();
+
+    const u64 chunk = fetched_;
+    if (chunk >= info_.num_chunks) {
+      exhausted_ = true;
+      return false;
+    }
+    ++claimed_chunks_;
+
+    // the initiator holds all queries, it only enqueues the indices
+    if (loopback_qp_) {
+      const u32 begin = chunk * info_.chunk_size;
+      const u32 end =
+        std::min<u32>(begin + info_.chunk_size, info_.num_queries);
+      for (u32 idx = begin; idx < end; ++idx) {
+        enqueue(worker, idx, (*queries_)[idx].type);
+      }
+
+      return true;
+    }
+
+    const u64 chunk_length = directory_[chunk + 1] - directory_[chunk];
+    qp_->post_send(*chunk_region_,
+                   chunk_length * sizeof(u32),
+                   IBV_WR_RDMA_READ,
+                   true,
+                   std::addressof(token_),
+                   directory_[chunk] * sizeof(u32));
+    context_->poll_send_cq_until_completion();
+
+    Queries claimed;
+    parse_batch(chunk_buffer_, claimed);
+
+    for (Query& q : claimed) {
+      const u32 idx = q.id;
+      const QueryType type = q.type;
+      (*queries_)[idx] = std::move(q);
+      enqueue(worker, idx, type);
+    }
+
+    return true;
+  }
+
+private:
+  vec<u_ptr<Worker>> workers_;
+  bool dynamic_{false};
+
+  bool separate_writes_{false};
+  u32 read_weight_{0};
+  u32 writer_threads_{0};
+
+  Context* context_{nullptr};
+  Queries* queries_{nullptr};
+  QueuePair* qp_{nullptr};
+
+  StreamInfo info_{};
+  vec<u64> directory_;  // chunk offsets into the stream (in u32)
+  MemoryRegionToken token_{};
+
+  // initiator only
+  Batch stream_;
+  u_ptr<MemoryRegion> stream_region_;
+  QP loopback_qp_;
+  QP loopback_peer_;
+
+  Batch chunk_buffer_;
+  u_ptr<LocalMemoryRegion> chunk_region_;
+  u64 fetched_{0};
+  u_ptr<LocalMemoryRegion> fetch_region_;
+
+  std::mutex refill_mutex_;
+  bool exhausted_{false};
+  u32 claimed_chunks_{0};
+};
+
+}  // namespace query
+
+#endif  // INDEX_QUERY_STREAM_HH
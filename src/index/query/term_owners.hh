@@ -0,0 +1,42 @@
+#ifndef INDEX_TERM_OWNERS_HH
+#define INDEX_TERM_OWNERS_HH
+
+#include <library/types.hh>
+
+namespace query {
+
+// with term ownership, all writes to a list are applied by a single compute
+// thread of the cluster, the owner is determined by hashing the term across
+// all compute threads (s.t. hot terms with adjacent ids spread out)
+class TermOwners {
+public:
+  TermOwners(u32 num_nodes, u32 num_threads)
+      : num_nodes_(num_nodes), num_threads_(num_threads) {}
+
+  u32 get_node(u32 term) const { return get_owner(term) / num_threads_; }
+  u32 get_thread(u32 term) const { return get_owner(term) % num_threads_; }
+
+private:
+  u32 get_owner(u32 term) const {
+    return hash(term) % (num_nodes_ * num_threads_);
+  }
+
+  // finalizer of murmur3
+  static u32 hash(u32 key) {
+    key ^= key >> 16;
+    key *= 0x85ebca6b;
+    key ^= key >> 13;
+    key *= 0xc2b2ae35;
+    key ^= key >> 16;
+
+    return key;
+  }
+
+private:
+  const u32 num_nodes_;
+  const u32 num_threads_;
+};
+
+}  // namespace query
+
+#endif  // INDEX_TERM_OWNERS_HH
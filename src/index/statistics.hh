@@ -6,6 +6,8 @@
 #include <ostream>
 
 #include "extern/nlohmann/json.hh"
+#include "index/constants.hh"
+#include "index/query/latency_histogram.hh"
 
 namespace statistics {
 
@@ -24,6 +26,22 @@ public:
     void inc() { ++count; }
   };
 
+  // counts of power-of-two buckets, output as an array
+  struct HistogramItem {
+    str name;
+    vec<CountItem<u64>> buckets;
+
+    HistogramItem(str&& name, u32 num_buckets) : name(name) {
+      for (u32 b = 0; b < num_buckets; ++b) {
+        buckets.emplace_back(name + "_" + std::to_string(b));
+      }
+    }
+  };
+
+  static constexpr u32 CONTENTION_BUCKETS =
+    inv_index::block_based::CONTENTION_BUCKETS;
+  static constexpr u32 LATENCY_BUCKETS = query::LatencyHistogram::NUM_BUCKETS;
+
 public:
   Statistics() {
     items_ = {std::ref(universe_size),
@@ -35,17 +53,54 @@ public:
               std::ref(allocated_read_buffers_size),
               std::ref(catalog_size),
               std::ref(num_read_queries),
-              std::ref(num_insert_queries)};
+              std::ref(num_insert_queries),
+              std::ref(num_delete_queries),
+              std::ref(dequeue_time_us),
+              std::ref(stolen_batches)};
 
     if constexpr (dynamic) {
       items_.insert(items_.end(),
-                    {std::ref(remote_allocations),
+                    {std::ref(rdma_writes_in_bytes),
+                     std::ref(remote_allocations),
                      std::ref(remote_deallocations),
                      std::ref(block_repeated_reads),
                      std::ref(locking_failed),
                      std::ref(read_failed),
                      std::ref(wait_for_write),
-                     std::ref(list_repeated_reads)});
+                     std::ref(list_repeated_reads),
+                     std::ref(insert_commits),
+                     std::ref(tail_hint_hits),
+                     std::ref(tail_hint_misses),
+                     std::ref(free_list_refills),
+                     std::ref(free_list_cas_failed),
+                     std::ref(pool_growths),
+                     std::ref(slot_reservations),
+                     std::ref(reservation_failed),
+                     std::ref(pipelined_inserts),
+                     std::ref(pipeline_fallbacks),
+                     std::ref(forwarded_updates),
+                     std::ref(delta_appends),
+                     std::ref(delta_full),
+                     std::ref(delta_reads_in_bytes),
+                     std::ref(ingested_postings),
+                     std::ref(ingested_blocks),
+                     std::ref(cache_hits),
+                     std::ref(cache_stale),
+                     std::ref(stale_locks_released),
+                     std::ref(lost_locks),
+                     std::ref(stale_blocks),
+                     std::ref(query_restarts),
+                     std::ref(created_heads),
+                     std::ref(catalog_pulls),
+                     std::ref(validated_blocks),
+                     std::ref(timed_validations),
+                     std::ref(validation_time_us),
+                     std::ref(backoff_time_us),
+                     std::ref(merged_blocks),
+                     std::ref(compactor_reads_in_bytes),
+                     std::ref(compacted_entries)});
+
+      histograms_ = {std::ref(lock_retries), std::ref(free_list_retries)};
     }
   }
 
@@ -61,7 +116,7 @@ public:
   void merge_json(const json& other) {
     for (auto& [key, value] : other.items()) {
       if (value.is_number()) {
-        set(key, get<u64>(key) + value.get<u64>());
+        set(key, get<u64>(key) + value.template get<u64>());
       } else {
         lib_failure("invalid type in statistics object");
       }
@@ -123,6 +178,15 @@ public:
       stats_[item.get().name] = item.get().count;
     }
 
+    for (auto& histogram : histograms_) {
+      json counts = json::array();
+      for (auto& bucket : histogram.get().buckets) {
+        counts.push_back(bucket.count);
+      }
+
+      stats_[histogram.get().name] = counts;
+    }
+
     return stats_;
   }
 
@@ -134,6 +198,7 @@ public:
   CountItem<u64> total_index_size{"total_initial_index_size"};
   CountItem<u64> total_index_buffer_size{"total_index_buffer_size"};
   CountItem<u64> rdma_reads_in_bytes{"rdma_reads_in_bytes"};
+  CountItem<u64> rdma_writes_in_bytes{"rdma_writes_in_bytes"};
   CountItem<u64> allocated_read_buffers_size{"allocated_read_buffers_size"};
   CountItem<u64> catalog_size{"catalog_size"};
 
@@ -141,16 +206,60 @@ public:
   CountItem<u64> remote_deallocations{"remote_deallocations"};
   CountItem<u64> block_repeated_reads{"block_repeated_reads"};
   CountItem<u64> list_repeated_reads{"list_repeated_reads"};
+  CountItem<u64> insert_commits{"insert_commits"};
+  CountItem<u64> tail_hint_hits{"tail_hint_hits"};
+  CountItem<u64> tail_hint_misses{"tail_hint_misses"};
+  CountItem<u64> free_list_refills{"free_list_refills"};
+  CountItem<u64> free_list_cas_failed{"free_list_cas_failed"};
+  CountItem<u64> pool_growths{"pool_growths"};
+  CountItem<u64> slot_reservations{"slot_reservations"};
+  CountItem<u64> reservation_failed{"reservation_failed"};
+  CountItem<u64> pipelined_inserts{"pipelined_inserts"};
+  CountItem<u64> pipeline_fallbacks{"pipeline_fallbacks"};
+  CountItem<u64> forwarded_updates{"forwarded_updates"};
+  CountItem<u64> delta_appends{"delta_appends"};
+  CountItem<u64> delta_full{"delta_full"};
+  CountItem<u64> delta_reads_in_bytes{"delta_reads_in_bytes"};
+  CountItem<u64> ingested_postings{"ingested_postings"};
+  CountItem<u64> ingested_blocks{"ingested_blocks"};
+  CountItem<u64> cache_hits{"cache_hits"};
+  CountItem<u64> cache_stale{"cache_stale"};
+  CountItem<u64> stale_locks_released{"stale_locks_released"};
+  CountItem<u64> lost_locks{"lost_locks"};
+  CountItem<u64> stale_blocks{"stale_blocks"};
+  CountItem<u64> query_restarts{"query_restarts"};
+  CountItem<u64> created_heads{"created_heads"};
+  CountItem<u64> catalog_pulls{"catalog_pulls"};
+  CountItem<u64> validated_blocks{"validated_blocks"};
+  CountItem<u64> timed_validations{"timed_validations"};
+  CountItem<u64> validation_time_us{"validation_time_us"};
+  CountItem<u64> backoff_time_us{"backoff_time_us"};
+  CountItem<u64> merged_blocks{"merged_blocks"};
+  CountItem<u64> compactor_reads_in_bytes{"compactor_reads_in_bytes"};
+  CountItem<u64> compacted_entries{"compacted_entries"};
 
   CountItem<u64> num_read_queries{"num_read_queries"};
   CountItem<u64> num_insert_queries{"num_insert_queries"};
+  CountItem<u64> num_delete_queries{"num_delete_queries"};
+
+  CountItem<u64> dequeue_time_us{"dequeue_time_us"};
+  CountItem<u64> stolen_batches{"stolen_batches"};
 
   CountItem<u64> locking_failed{"locking_failed"};
   CountItem<u64> read_failed{"read_failed"};
   CountItem<u64> wait_for_write{"wait_for_write"};
 
+  // failed CASs per successful CAS (0, 1, 2-3, 4-7, ...)
+  HistogramItem lock_retries{"lock_retries", CONTENTION_BUCKETS};
+  HistogramItem free_list_retries{"free_list_retries", CONTENTION_BUCKETS};
+
+  // latencies of reads and writes (only reported as percentiles)
+  HistogramItem read_latency{"read_latency", LATENCY_BUCKETS};
+  HistogramItem write_latency{"write_latency", LATENCY_BUCKETS};
+
 protected:
   vec<std::reference_wrapper<CountItem<u64>>> items_;
+  vec<std::reference_wrapper<HistogramItem>> histograms_;
 
 private:
   json stats_;
@@ -42,6 +42,7 @@ public:
   u64 local_num_result{0};
   u64 rdma_reads_in_bytes{0};
   u64 processed_queries{0};
+  u64 split_queries{0};
   std::atomic<i32> post_balance{0};
 
   // initializes the query_handler
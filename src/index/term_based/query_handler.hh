@@ -1,6 +1,7 @@
 #ifndef INDEX_TERM_BASED_QUERY_HANDLER_HH
 #define INDEX_TERM_BASED_QUERY_HANDLER_HH
 
+#include <algorithm>
 #include <library/latch.hh>
 
 #include "compute_thread.hh"
@@ -9,6 +10,7 @@
 #include "index/constants.hh"
 #include "index/operations.hh"
 #include "index/query/query.hh"
+#include "index/query/query_stream.hh"
 #include "index/shared_context.hh"
 #include "remote_pointer.hh"
 
@@ -18,8 +20,8 @@ class TermBasedQueryHandler {
 public:
   using Configuration = configuration::IndexConfiguration;
   using ComputeThreads = vec<u_ptr<ComputeThread>>;
-  using SharedContext = SharedContext<ComputeThread>;
-  using Queue = concurrent_queue<u32>;
+  using SharedContext = ::SharedContext<ComputeThread>;
+  using Queue = query::QueryStream;
   inline static const str name = "term";
 
 public:
@@ -123,6 +125,16 @@ public:
 
   ComputeThreads& get_compute_threads() { return compute_threads_; }
 
+  // in entries
+  u64 get_list_length(u32 term) const {
+    return term < remote_pointers_.size() ? remote_pointers_[term].length : 0;
+  }
+
+  // queries whose lists sum up to at least the threshold are split
+  void set_split_threshold(u64 split_threshold) {
+    split_threshold_ = split_threshold;
+  }
+
   void process_queries(Queue& query_queue,
                        query::Queries& queries,
                        MemoryRegionTokens& remote_access_tokens,
@@ -132,8 +144,9 @@ public:
     start_latch_.arrive_and_wait();
     u32 q;  // idx to query
 
-    // try pop queue
-    while (query_queue.try_dequeue(q)) {
+    // try pop queue (parts of split queries are processed first)
+    while (help_with_split_queries(compute_thread, operation),
+           query_queue.try_dequeue(q, thread_id)) {
       query::Query& query = queries[q];
       if (query.type != QueryType::READ) {
         continue;
@@ -187,6 +200,14 @@ public:
       }
       compute_thread->t_poll->stop();
 
+      // very large queries are split by document id range across threads
+      if (split_threshold_ > 0 && num_compute_threads_ > 1 &&
+          buffer_offsets.back() >= split_threshold_) {
+        compute_split_query(
+          compute_thread, operation, begin_addresses, end_addresses);
+        continue;
+      }
+
       // compute operation
       compute_thread->t_operation->start();
       if (operation == Configuration::Operation::intersection) {
@@ -202,6 +223,107 @@ public:
     end_latch_.arrive_and_wait();
   }
 
+private:
+  // part of a split query: all lists restricted to a document id range
+  struct SplitTask {
+    vec<u32*> begin_addresses;
+    vec<u32*> end_addresses;
+    std::atomic<u32>* remaining_tasks;
+  };
+
+  void compute_split_task(u_ptr<ComputeThread>& compute_thread,
+                          Configuration::Operation operation,
+                          SplitTask& task) {
+    auto result_handler = [&](u32) { compute_thread->local_num_result++; };
+
+    compute_thread->t_operation->start();
+    if (operation == Configuration::Operation::intersection) {
+      operations::compute_intersection(
+        result_handler, task.begin_addresses, task.end_addresses);
+    } else {
+      operations::compute_union(
+        result_handler, task.begin_addresses, task.end_addresses);
+    }
+    compute_thread->t_operation->stop();
+
+    task.remaining_tasks->fetch_sub(1);
+  }
+
+  void help_with_split_queries(u_ptr<ComputeThread>& compute_thread,
+                               Configuration::Operation operation) {
+    SplitTask task;
+    while (split_tasks_.try_dequeue(task)) {
+      compute_split_task(compute_thread, operation, task);
+    }
+  }
+
+  // partitions the local lists by binary search on document ids taken from
+  // the shortest list (intersection) or the longest list (union)
+  void compute_split_query(u_ptr<ComputeThread>& compute_thread,
+                           Configuration::Operation operation,
+                           vec<u32*>& begin_addresses,
+                           vec<u32*>& end_addresses) {
+    const bool intersection =
+      operation == Configuration::Operation::intersection;
+    const auto length = [&](u32 i) {
+      return end_addresses[i] - begin_addresses[i];
+    };
+
+    u32 pivot_list = 0;
+    for (u32 i = 1; i < begin_addresses.size(); ++i) {
+      if (intersection ? length(i) < length(pivot_list)
+                       : length(i) > length(pivot_list)) {
+        pivot_list = i;
+      }
+    }
+
+    const u64 pivot_length = length(pivot_list);
+    const u32 num_tasks =
+      std::min<u64>(num_compute_threads_, std::max<u64>(pivot_length, 1));
+
+    // document ids at which the ranges begin
+    vec<u32> pivots;
+    for (u32 t = 1; t < num_tasks; ++t) {
+      const u32 pivot =
+        begin_addresses[pivot_list][t * pivot_length / num_tasks];
+      if (pivots.empty() || pivots.back() < pivot) {
+        pivots.push_back(pivot);
+      }
+    }
+
+    std::atomic<u32> remaining_tasks{static_cast<u32>(pivots.size() + 1)};
+    vec<SplitTask> tasks(pivots.size() + 1);
+
+    for (u32 t = 0; t < tasks.size(); ++t) {
+      SplitTask& task = tasks[t];
+      task.remaining_tasks = &remaining_tasks;
+
+      for (u32 i = 0; i < begin_addresses.size(); ++i) {
+        task.begin_addresses.push_back(
+          t == 0 ? begin_addresses[i]
+                 : std::lower_bound(
+                     begin_addresses[i], end_addresses[i], pivots[t - 1]));
+        task.end_addresses.push_back(
+          t == pivots.size()
+            ? end_addresses[i]
+            : std::lower_bound(
+                begin_addresses[i], end_addresses[i], pivots[t]));
+      }
+    }
+
+    compute_thread->split_queries++;
+    for (u32 t = 1; t < tasks.size(); ++t) {
+      split_tasks_.enqueue(tasks[t]);
+    }
+
+    compute_split_task(compute_thread, operation, tasks[0]);
+
+    // help other threads until all parts of this query are done
+    while (remaining_tasks > 0) {
+      help_with_split_queries(compute_thread, operation);
+    }
+  }
+
 private:
   const u32 num_compute_threads_;
   const i32 max_send_queue_wr_;
@@ -214,6 +336,9 @@ private:
 
   Latch start_latch_{};
   Latch end_latch_{};
+
+  u64 split_threshold_{0};  // in entries
+  concurrent_queue<SplitTask> split_tasks_;
 };
 
 }  // namespace inv_index::term_based